@@ -0,0 +1,379 @@
+// Benchmarks of schema compiling, lexing and matching. Every case is written
+// to the output file (bench_output.txt by default) as one JSON object per
+// line:
+//
+//   ns_per_arg       - parse time divided by argc - 1 (or by aliases for compile)
+//   allocs_per_parse - allocator calls of one parse, results included
+//   peak_rss_kb      - process peak RSS after the case, cases go from small to big
+//   threads          - threads of the parallel batch cases, 1 for the rest
+//   cores            - online CPUs, the threads cases can't scale past it
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#define EXT_ARGS_IMPLEMENTATION
+#include "ext_args.h"
+
+typedef struct {
+  long allocs;
+} Counter;
+
+static void *counting_alloc(void *ud, size_t size) {
+  ((Counter *)ud)->allocs++;
+  return malloc(size);
+}
+
+static void *counting_realloc(void *ud, void *ptr, size_t oldSize, size_t size) {
+  (void)oldSize;
+  ((Counter *)ud)->allocs++;
+  return realloc(ptr, size);
+}
+
+static void counting_free(void *ud, void *ptr) {
+  (void)ud;
+  free(ptr);
+}
+
+static FILE *out;
+static int threads = 1;
+static long cores = 1;
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+// Enough iterations for about 2M processed arguments per case
+static int iterations(int n) {
+  int it = 2000000 / (n > 0 ? n : 1);
+  return it < 1 ? 1 : it > 100000 ? 100000 : it;
+}
+
+static void report(const char *name, int aliases, int argc, int repeatPct, int it, double ns, int perUnit,
+    long allocs, int res) {
+  fprintf(out, "{\"case\":\"%s\",\"aliases\":%d,\"argc\":%d,\"repeat_pct\":%d,\"iterations\":%d,"
+               "\"ns_per_arg\":%.2f,\"allocs_per_parse\":%.2f,\"peak_rss_kb\":%ld,\"threads\":%d,\"cores\":%ld,"
+               "\"result\":%d}\n",
+          name, aliases, argc, repeatPct, it, ns / it / (perUnit > 0 ? perUnit : 1),
+          (double)allocs / it, peak_rss_kb(), threads, cores, res);
+  fflush(out);
+  printf("%-8s aliases=%-6d argc=%-8d repeat=%3d%% threads=%-3d %10.2f ns/arg\n", name, aliases, argc, repeatPct,
+         threads, ns / it / (perUnit > 0 ? perUnit : 1));
+}
+
+static int sparse_ex(const ext_args_schema *schema, const ext_args_options *opts, int argc, char *argv[],
+    char **oerr, ...) {
+  va_list ap;
+  va_start(ap, oerr);
+  int res = ext_args_parse_ex(schema, opts, argc, argv, ap, oerr);
+  va_end(ap);
+  return res;
+}
+
+// "[--o0=val...] [--o1=val...] ..." with `n` aliases
+static char *many_aliases_fmt(int n) {
+  char *fmt = malloc(n * 24 + 1);
+  char *p = fmt;
+  for(int i = 0; i < n; i++) {
+    p += sprintf(p, "%s[--o%d=val...]", i ? " " : "", i);
+  }
+  *p = '\0';
+  return fmt;
+}
+
+static void bench_compile(int aliases) {
+  Counter c = {0};
+  ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+  char *fmt = many_aliases_fmt(aliases);
+  int it = iterations(aliases * 20);
+
+  int res = EXT_ARGS_NO_ERR;
+  double start = now_ns();
+  for(int i = 0; i < it; i++) {
+    ext_args_schema *schema;
+    char *err;
+    res = ext_args_compile_ex(fmt, &allocator, &schema, &err);
+    ext_args_schema_free(schema);
+  }
+  report("compile", aliases, 0, 0, it, now_ns() - start, aliases, c.allocs, res);
+  free(fmt);
+}
+
+// Loading the schema saved by `ext_args_compile_cached`
+static void bench_cached(int aliases) {
+  Counter c = {0};
+  ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+  char *fmt = many_aliases_fmt(aliases);
+  const char *path = "ext_args_bench.schema";
+  int it = iterations(aliases * 20);
+
+  ext_args_schema *schema;
+  char *err;
+  remove(path);
+  int res = ext_args_compile_cached(fmt, path, NULL, &schema, &err);
+  ext_args_schema_free(schema);
+
+  double start = now_ns();
+  for(int i = 0; i < it && res == EXT_ARGS_NO_ERR; i++) {
+    res = ext_args_compile_cached(fmt, path, &allocator, &schema, &err);
+    ext_args_schema_free(schema);
+  }
+  report("cached", aliases, 0, 0, it, now_ns() - start, aliases, c.allocs, res);
+  remove(path);
+  free(fmt);
+}
+
+// Every argument matches one of `aliases` repeating options
+static void bench_match(int aliases, int argc) {
+  char *fmt = many_aliases_fmt(aliases);
+  ext_args_schema *schema;
+  ext_args_bound *bound;
+  char *err;
+  ext_args_compile(fmt, &schema, &err);
+  ext_args_bind(schema, (ext_args_binding[]){EXT_ARGS_BIND_END}, &bound, &err);
+
+  char **argv = malloc(sizeof(*argv) * argc);
+  char *strs = malloc((size_t)argc * 24);
+  argv[0] = "";
+  for(int i = 1; i < argc; i++) {
+    argv[i] = strs + (size_t)i * 24;
+    sprintf(argv[i], "--o%u=v", (unsigned)(i * 2654435761u) % aliases);
+  }
+
+  Counter c = {0};
+  ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+  ext_args_options opts = {.allocator = &allocator};
+  int it = iterations(argc);
+
+  int res = EXT_ARGS_NO_ERR;
+  double start = now_ns();
+  for(int i = 0; i < it; i++) {
+    res = ext_args_parse_into(bound, &opts, argc, argv, NULL, &err);
+  }
+  report("match", aliases, argc, 100, it, now_ns() - start, argc - 1, c.allocs, res);
+
+  free(strs);
+  free(argv);
+  ext_args_bound_free(bound);
+  ext_args_schema_free(schema);
+  free(fmt);
+}
+
+// A typical schema, `repeatPct` of the arguments are "-D=x", the rest are
+// positional. Results are built and freed as a caller would
+static void bench_argc(int argc, int repeatPct) {
+  ext_args_schema *schema;
+  char *err;
+  ext_args_compile("[-f|--file=val] [-v] [-D=val...] [-n=val:int] ...", &schema, &err);
+
+  char **argv = malloc(sizeof(*argv) * argc);
+  argv[0] = "";
+  for(int i = 1; i < argc; i++) {
+    argv[i] = (int)((unsigned)(i * 2654435761u) % 100) < repeatPct ? "-D=x" : "file";
+  }
+
+  Counter c = {0};
+  ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+  ext_args_options opts = {.allocator = &allocator};
+  int it = iterations(argc);
+
+  int res = EXT_ARGS_NO_ERR;
+  double start = now_ns();
+  for(int i = 0; i < it; i++) {
+    char **d, **files;
+    res = sparse_ex(schema, &opts, argc, argv, &err, NULL, NULL, &d, NULL, &files);
+    free(d);
+    free(files);
+  }
+  report("argc", 0, argc, repeatPct, it, now_ns() - start, argc - 1, c.allocs, res);
+
+  free(argv);
+  ext_args_schema_free(schema);
+}
+
+// `n` short vectors validated one by one and as one batch, every fourth of
+// them is rejected
+static void bench_batch(int n) {
+  ext_args_schema *schema;
+  char *err;
+  ext_args_compile("[-f|--file=val] [-v] [-D=val...] [-n=val:int] src [dst]", &schema, &err);
+
+  char **argvs[] = {
+    (char *[]){"", "-v", "-D=x", "src"},
+    (char *[]){"", "--file=a", "src", "dst"},
+    (char *[]){"", "-n=12", "-D=y", "src"},
+    (char *[]){"", "-n=x", "-v", "src"}
+  };
+  char ***vecs = malloc(sizeof(*vecs) * n);
+  int *argcs = malloc(sizeof(*argcs) * n);
+  int *status = malloc(sizeof(*status) * n);
+  uint64_t *used = malloc(sizeof(*used) * n * ext_args_batch_words(schema));
+  for(int i = 0; i < n; i++) {
+    vecs[i] = argvs[i % 4];
+    argcs[i] = 4;
+  }
+
+  Counter c = {0};
+  ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+  ext_args_options opts = {.allocator = &allocator};
+  int it = iterations(n * 3);
+
+  int res = EXT_ARGS_NO_ERR;
+  double start = now_ns();
+  for(int i = 0; i < it; i++) {
+    for(int j = 0; j < n; j++) {
+      res = sparse_ex(schema, &opts, argcs[j], vecs[j], &err, NULL, NULL, NULL, NULL, NULL, NULL);
+      free(err);
+    }
+  }
+  report("single", 0, n, 0, it, now_ns() - start, n * 3, c.allocs, res);
+
+  c.allocs = 0;
+  ext_args_batch_out out = {status, used};
+  start = now_ns();
+  for(int i = 0; i < it; i++) {
+    res = ext_args_parse_batch(schema, &opts, n, argcs, vecs, &out);
+  }
+  report("batch", 0, n, 0, it, now_ns() - start, n * 3, c.allocs, res);
+
+  free(used);
+  free(status);
+  free(argcs);
+  free(vecs);
+  ext_args_schema_free(schema);
+}
+
+// 100000 vectors validated by `ext_args_parse_batch_mt` in 1 to 32 threads.
+// Wall time per argument, near linear scaling needs as many cores
+static void bench_threads(void) {
+  enum { N = 100000 };
+  ext_args_schema *schema;
+  char *err;
+  ext_args_compile("[-f|--file=val] [-v] [-D=val...] [-n=val:int] src [dst]", &schema, &err);
+
+  char **argvs[] = {
+    (char *[]){"", "-v", "-D=x", "src"},
+    (char *[]){"", "--file=a", "src", "dst"},
+    (char *[]){"", "-n=12", "-D=y", "src"},
+    (char *[]){"", "-n=x", "-v", "src"}
+  };
+  char ***vecs = malloc(sizeof(*vecs) * N);
+  int *argcs = malloc(sizeof(*argcs) * N);
+  int *status = malloc(sizeof(*status) * N);
+  uint64_t *used = malloc(sizeof(*used) * N * ext_args_batch_words(schema));
+  for(int i = 0; i < N; i++) {
+    vecs[i] = argvs[i % 4];
+    argcs[i] = 4;
+  }
+
+  ext_args_batch_out bo = {status, used};
+  int it = iterations(N * 3) * 10;
+  for(threads = 1; threads <= 32; threads *= 2) {
+    int res = EXT_ARGS_NO_ERR;
+    double start = now_ns();
+    for(int i = 0; i < it; i++) {
+      res = ext_args_parse_batch_mt(schema, NULL, N, argcs, vecs, &bo, threads);
+    }
+    report("threads", 0, N, 0, it, now_ns() - start, N * 3, 0, res);
+  }
+  threads = 1;
+
+  free(used);
+  free(status);
+  free(argcs);
+  free(vecs);
+  ext_args_schema_free(schema);
+}
+
+// Errors found at the end of the input: an unknown option, a bad typed
+// value and a missing required argument
+static void bench_errors(int argc) {
+  static const char *cases[][2] = {
+    {"unknown", "--nope"},
+    {"badvalue", "-n=12x"},
+    {"missing", "file"}
+  };
+
+  ext_args_schema *schema;
+  char *err;
+  ext_args_compile("[-v] [-D=val...] [-n=val:int] -r=val ...", &schema, &err);
+
+  char **argv = malloc(sizeof(*argv) * argc);
+  argv[0] = "";
+  for(int i = 1; i < argc; i++) {
+    argv[i] = i % 2 ? "-D=x" : "file";
+  }
+
+  for(int k = 0; k < (int)(sizeof(cases) / sizeof(*cases)); k++) {
+    if(k != 2) {
+      argv[argc - 2] = "-r=1";
+    }
+    argv[argc - 1] = (char *)cases[k][1];
+
+    Counter c = {0};
+    ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+    ext_args_options opts = {.allocator = &allocator};
+    int it = iterations(argc);
+
+    int res = EXT_ARGS_NO_ERR;
+    double start = now_ns();
+    for(int i = 0; i < it; i++) {
+      res = sparse_ex(schema, &opts, argc, argv, &err, NULL, NULL, NULL, NULL, NULL);
+      free(err);
+    }
+    report(cases[k][0], 0, argc, 50, it, now_ns() - start, argc - 1, c.allocs, res);
+    argv[argc - 2] = "file";
+  }
+
+  free(argv);
+  ext_args_schema_free(schema);
+}
+
+int main(int argc, char *argv[]) {
+  const char *path = argc > 1 ? argv[1] : "bench_output.txt";
+  out = fopen(path, "w");
+  if(!out) {
+    perror(path);
+    return EXIT_FAILURE;
+  }
+  cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  static const int aliases[] = {1, 10, 100, 1000, 10000};
+  static const int argcs[] = {2, 10, 100, 1000, 10000, 100000, 1000000};
+  static const int repeats[] = {0, 50, 100};
+
+  for(int i = 0; i < (int)(sizeof(aliases) / sizeof(*aliases)); i++) {
+    bench_compile(aliases[i]);
+    bench_cached(aliases[i]);
+  }
+  for(int i = 0; i < (int)(sizeof(aliases) / sizeof(*aliases)); i++) {
+    bench_match(aliases[i], 1000);
+  }
+  for(int i = 0; i < (int)(sizeof(argcs) / sizeof(*argcs)); i++) {
+    for(int j = 0; j < (int)(sizeof(repeats) / sizeof(*repeats)); j++) {
+      bench_argc(argcs[i], repeats[j]);
+    }
+  }
+  for(int i = 0; i < (int)(sizeof(argcs) / sizeof(*argcs)); i++) {
+    if(argcs[i] >= 10) {
+      bench_errors(argcs[i]);
+    }
+  }
+  for(int i = 0; i < (int)(sizeof(argcs) / sizeof(*argcs)); i++) {
+    if(argcs[i] >= 10 && argcs[i] <= 100000) {
+      bench_batch(argcs[i]);
+    }
+  }
+  bench_threads();
+
+  fclose(out);
+  return 0;
+}
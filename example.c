@@ -1,4 +1,5 @@
 #include <stdio.h>
+#define EXT_ARGS_IMPLEMENTATION
 #include "ext_args.h"
 
 char *eargs(int argc, char *argv[], char *fmt, ...) {
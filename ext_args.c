@@ -0,0 +1,3 @@
+// Implementation unit for linking ext_args as a library, see "Linking" in ext_args.h
+#define EXT_ARGS_IMPLEMENTATION
+#include "ext_args.h"
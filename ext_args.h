@@ -13,10 +13,12 @@
 
   USAGE
 
-  First create your wrapper function where you can specify how you want to
-  handle errors:
+  Define EXT_ARGS_IMPLEMENTATION in exactly one C file before including the
+  header, other files include it as usual. Then create your wrapper function
+  where you can specify how you want to handle errors:
 
     #include <stdio.h>
+    #define EXT_ARGS_IMPLEMENTATION
     #include "ext_args.h"
 
     char *eargs(int argc, char *argv[], char *fmt, ...) {
@@ -191,11 +193,429 @@
       }
     }
 
+  Precompiled schemas:
+
+  `ext_args` compiles `fmt` on every call. When the same schema is used many
+  times, compile it once with `ext_args_compile` and parse with
+  `ext_args_parse`. A compiled schema is never modified by parsing, so it
+  can be shared between threads.
+
+    int sparse(ext_args_schema *schema, int argc, char *argv[], char **oerr, ...) {
+      va_list ap;
+      va_start(ap, oerr);
+      int res = ext_args_parse(schema, argc, argv, ap, oerr);
+      va_end(ap);
+      return res;
+    }
+
+    {
+      ext_args_schema *schema;
+      char *err;
+      if(ext_args_compile("-f|--flag=val [-v] ...", &schema, &err) != EXT_ARGS_NO_ERR) {
+        ...
+      }
+
+      char *f, **files;
+      bool v;
+      for(...) {
+        err = NULL;
+        if(sparse(schema, job->argc, job->argv, &err, &f, &v, &files) == EXT_ARGS_NO_ERR) {
+          ...
+          free(files);
+        }
+        free(err);
+      }
+
+      ext_args_schema_free(schema);
+    }
+
+  Arena:
+
+  `ext_args_parse_ex` takes options. With `arena` set, the scratch memory, the
+  result arrays and the error string are placed in a caller provided buffer
+  and nothing has to be freed one by one. EXT_ARGS_NO_MEM_ERR is returned when
+  the buffer is too small.
+
+    static char buf[64 * 1024];
+    ext_args_arena arena;
+    ext_args_arena_init(&arena, buf, sizeof(buf));
+    ext_args_options opts = {.arena = &arena};
+
+    for(...) {
+      int res = sparse_ex(schema, &opts, job->argc, job->argv, &err, &f, &v, &files);
+      ...
+      ext_args_arena_reset(&arena);
+    }
+
+  Allocators:
+
+  By default memory comes from `malloc`, `realloc` and `free`. Define
+  EXT_ARGS_MALLOC, EXT_ARGS_REALLOC and EXT_ARGS_FREE before including the
+  header to replace them everywhere, or pass an `ext_args_allocator` at
+  runtime to `ext_args_compile_ex` and in `ext_args_options`. The result
+  arrays and the error strings are then released with the same allocator.
+
+    ext_args_allocator slab = {slab_alloc, slab_realloc, slab_free, threadSlab};
+    ext_args_options opts = {.allocator = &slab};
+
+  Typed values:
+
+  A value name may be followed by a type, then the value is converted and
+  range checked, and the variable receives the typed value instead of a
+  string. A conversion failure is EXT_ARGS_INPUT_ERR and nothing is written.
+  Typed variables of optional arguments that are not provided, or given
+  without an optional value, keep their values, so initialize them with the
+  defaults. Repeating arguments can't be
+  typed.
+
+    type           | variable type      | accepts
+    ---------------+--------------------+-------------------------------------
+    str            | char *             | anything, the default
+    int            | long long          | -42, +7
+    uint           | unsigned long long | 42
+    f64            | double             | 2.5, 1e-3, always with '.'
+    size           | size_t             | 512, 64K, 2M, 1GiB, 1T
+    duration       | double, seconds    | 1.5, 250ms, 10us, 100ns, 5m, 2h
+    bool           | bool               | true/false, yes/no, on/off, 1/0
+
+    long long threads = 4;
+    double timeout = 30;
+    size_t buf = 64 * 1024;
+    char *err = eargs(argc, argv, "[--threads=n:int] [--timeout=val:duration] [--buf=val:size]",
+                      &threads, &timeout, &buf);
+
+  The conversions are public too, `ext_args_conv_int` to `ext_args_conv_bool`
+  return EXT_ARGS_CONV_OK, EXT_ARGS_CONV_INVALID or EXT_ARGS_CONV_RANGE.
+
+  Binding to a struct:
+
+  Instead of a list of pointers, the arguments may be bound to the fields of
+  a config struct. `ext_args_bind` resolves a binding table against a compiled
+  schema once and checks every field size against the argument's variable
+  type. `ext_args_parse_into` then fills any number of structs with no
+  varargs. Names are any alias of a floating argument, a positional argument
+  name or "..." for the variadic ones. Unbound arguments are skipped.
+  Bindings are best written with the typed macros EXT_ARGS_BIND_STR, _LIST,
+  _BOOL, _INT, _UINT, _F64 and _SIZE, `ext_args_bind` rejects a type that
+  doesn't match the argument. The untyped EXT_ARGS_BIND checks the size only,
+  so it can't tell apart `long long`, `double` and `char *` fields.
+
+    typedef struct {
+      char *file;
+      bool verbose;
+      long long threads;
+      char **rest;
+    } Config;
+
+    static const ext_args_binding table[] = {
+      EXT_ARGS_BIND_STR(Config, file, "--file"),
+      EXT_ARGS_BIND_BOOL(Config, verbose, "-v"),
+      EXT_ARGS_BIND_INT(Config, threads, "--threads"),
+      EXT_ARGS_BIND_LIST(Config, rest, "..."),
+      EXT_ARGS_BIND_END
+    };
+
+    ext_args_bound *bound;
+    if(ext_args_bind(schema, table, &bound, &err) != EXT_ARGS_NO_ERR) {
+      ...
+    }
+    for(...) {
+      Config cfg = {.threads = 4};
+      if(ext_args_parse_into(bound, NULL, job->argc, job->argv, &cfg, &err) == EXT_ARGS_NO_ERR) {
+        ...
+        free(cfg.rest);
+      }
+    }
+    ext_args_bound_free(bound);
+
+  Streaming:
+
+  When the arguments arrive one by one, `ext_args_feed` lexes, matches, checks
+  and assigns each of them right away, and `ext_args_finish` checks the
+  required ones and assigns the defaults. Memory doesn't grow with the input.
+  Values go to the fields of a bound struct (see "Binding to a struct"), the
+  values of repeating and variadic arguments are passed to a callback instead
+  of being collected. The callback's `id` is the argument's position in the
+  schema, the variadic ones come last. The fed strings must stay valid as long
+  as the values are used. A failed feed releases the stream, otherwise
+  `ext_args_finish` releases it. A failed stream keeps answering with the
+  same error, feeding a finished one is an error too. Like a one-shot parse,
+  `ext_args_finish` takes the arguments not fed from the environment and a
+  config file, set `envp` and `config` in the stream after init for them.
+
+    void onValue(void *ud, int id, const char *alias, int aliasLen, char *val) {
+      ...
+    }
+
+    ext_args_stream st;
+    Config cfg = {0};
+    if(ext_args_stream_init(&st, bound, &cfg, onValue, ud) != EXT_ARGS_NO_ERR) {
+      ...
+    }
+    while((arg = readArg(pipe))) {
+      if(ext_args_feed(&st, arg, &err) != EXT_ARGS_NO_ERR) {
+        ...
+      }
+    }
+    if(ext_args_finish(&st, &err) != EXT_ARGS_NO_ERR) {
+      ...
+    }
+
+  Emitting values:
+
+  With `emit` set in `ext_args_options`, the values of repeating and variadic
+  positional arguments are passed to the callback (the same one as in
+  "Streaming") and no arrays are built, so there is nothing to free. Their
+  variables are left untouched and may be NULL. Repeating values come first,
+  then the variadic ones, both in the input order.
+
+    ext_args_options opts = {.emit = onValue, .ud = &paths};
+    int res = sparse_ex(schema, &opts, argc, argv, &err, NULL, &out, NULL);
+
+  Response files:
+
+  With `responseFiles` set in `ext_args_options`, an "@path" argument is
+  replaced with the arguments read from the file. Arguments are separated by
+  whitespace, single quotes keep text literally, double quotes and unquoted
+  text take backslash escapes. Response files may include other ones up to
+  `maxDepth` levels (EXT_ARGS_RESPONSE_DEPTH, 8 by default). Files are memory
+  mapped and split in place, the values point into the mappings, so release
+  them after the values are used. Define EXT_ARGS_NO_MMAP to read files with
+  stdio instead.
+
+    ext_args_response_files rsp = {0};
+    ext_args_options opts = {.responseFiles = &rsp};
+    int res = sparse_ex(schema, &opts, argc, argv, &err, &inc, &out, &files);
+    ...
+    ext_args_response_files_release(&rsp);
+
+  Environment variables:
+
+  A value may be bound to an environment variable, written after the value
+  name and type: `--threads=n:int@APP_THREADS`. When the argument isn't given
+  on the command line, the variable's value is used as if it was, so it also
+  satisfies required arguments. The command line wins, empty variables are
+  ignored. The environment is walked once per parse, once per call for a
+  batch, `envp` in `ext_args_options` replaces `environ`.
+
+    long long threads = 4;
+    char *mode;
+    char *err = eargs(argc, argv, "[--threads=n:int@APP_THREADS] [--mode=val@APP_MODE]", &threads, &mode);
+
+  Config files:
+
+  Defaults may come from a `key = value` file. `ext_args_config_load` reads it
+  once, then it's passed in `ext_args_options` to any number of parses. Keys
+  are matched as "--key", then as "-key", through the same aliases lookup as
+  the command line, and the values go through the same checks. Flags take
+  true/false, yes/no, on/off, 1/0 or a key alone. Lines starting with '#' or
+  ';' are comments, values may be double quoted to keep spaces. The file is
+  memory mapped and the values point into it, free it after the values are
+  used. The command line wins over the environment, the environment over the
+  file, and the file over the defaults.
+
+    # app.conf
+    threads = 16
+    output = "/var/out"
+    verbose
+
+    ext_args_config *cfg;
+    if(ext_args_config_load("app.conf", NULL, &cfg, &err) != EXT_ARGS_NO_ERR) {
+      ...
+    }
+    ext_args_options opts = {.config = cfg};
+    int res = sparse_ex(schema, &opts, argc, argv, &err, &threads, &output, &verbose);
+    ...
+    ext_args_config_free(cfg);
+
+  Linking:
+
+  The header declares the API everywhere and contains the implementation only
+  where `EXT_ARGS_IMPLEMENTATION` is defined, so the parser is compiled once per
+  program instead of once per file. Define `EXT_ARGS_STATIC` too to keep every
+  function private to that file, the way the single file builds worked before.
+
+  `make lib` builds `libext_args.a` and `libext_args.so` from `ext_args.c`.
+  Only the public `ext_args_*` symbols are exported, the internals are hidden,
+  so link time optimization can inline and drop them freely.
+
+    // main.c
+    #define EXT_ARGS_IMPLEMENTATION
+    #include "ext_args.h"
+
+    // other.c, or every file when linking with -lext_args
+    #include "ext_args.h"
+
+  Compile-time schemas:
+
+  Fixed schemas can be written as X-macro lists instead of strings.
+  `EXT_ARGS_DEFINE_SCHEMA` expands a list into static const tables and a
+  function returning the schema, so nothing is lexed or allocated at runtime.
+  The list is `GROUP(id, flags, type, env, aliases...)` and `POS(id, flags)`
+  entries in the schema order, `env` is "" when there is no environment
+  variable. The tables aren't checked like `ext_args_compile` does, and the
+  schema is never freed.
+
+    // "[-f|--file=val] [-v] [-D=val...] [-n=val:int@NUM] src [dst] ..."
+    #define TOOL_SCHEMA(GROUP, POS) \
+      GROUP(file, EXT_ARGS_F_OPTIONAL | EXT_ARGS_F_VALUE, EXT_ARGS_T_STR, "", "-f", "--file") \
+      GROUP(verbose, EXT_ARGS_F_OPTIONAL, EXT_ARGS_T_STR, "", "-v") \
+      GROUP(define, EXT_ARGS_F_OPTIONAL | EXT_ARGS_F_REPEATING, EXT_ARGS_T_STR, "", "-D") \
+      GROUP(num, EXT_ARGS_F_OPTIONAL | EXT_ARGS_F_VALUE, EXT_ARGS_T_INT, "NUM", "-n") \
+      POS(src, 0) \
+      POS(dst, EXT_ARGS_F_OPTIONAL)
+
+    EXT_ARGS_DEFINE_SCHEMA(tool_schema, TOOL_SCHEMA, true)
+
+    int res = ext_args_parse(tool_schema(), argc, argv, ap, &err);
+
+  Schema compiler:
+
+  `ext_args_gen` compiles a schema string offline into a header for that
+  schema alone: a `<name>_args` struct with a typed field per argument, the
+  schema tables as static const data, a matcher switching on the alias length
+  and then on its most distinctive character, and `<name>_parse` written for
+  the schema. It walks `argv` once, converts each value straight into its
+  typed field with `ext_args_conv_*` and checks the required options with a
+  bitmask, the errors are the runtime's ones. The struct is only written on
+  success. Repeating and variadic fields are arrays, as with
+  `ext_args_parse_into`, which still handles the options reading files or
+  counting: `responseFiles`, `config`, `emit` and `stats`.
+
+    // ./ext_args_gen -o=job_args.h job "[-q|--queue=name] [-n=count:int] [-v] script ..."
+    #include "ext_args.h"
+    #include "job_args.h"
+
+    job_args job = {.n = 1};
+    char *err;
+    if(job_parse(NULL, argc, argv, &job, &err) == EXT_ARGS_NO_ERR) {
+      printf("%s x%lld\n", job.script, job.n);
+      free(job.rest);
+    }
+
+  Saved schemas:
+
+  `ext_args_compile_cached` maps a schema saved by an earlier run instead of
+  compiling it. The file has no pointers: strings are offsets into the schema
+  string stored in it, and the sequence and aliases index are used in place
+  from the page cache. Only the rows holding strings are rebuilt. A file that
+  was compiled from another schema string, is corrupt (its checksum is wrong)
+  or has another format version is ignored. In that case the schema is
+  compiled and saved again.
+
+  Reading a file costs a few system calls. The cache pays off for schemas
+  with hundreds of aliases or more, small schemas compile faster, see
+  `make bench`.
+
+    ext_args_schema *schema;
+    char *err;
+    int res = ext_args_compile_cached(fmt, "/var/cache/tool/args.schema", NULL, &schema, &err);
+
+  Abbreviations:
+
+  With `abbrev` set in the options, unambiguous prefixes of the "--" aliases
+  are accepted the way getopt_long accepts them: "--verb" for "--verbose".
+  Exact matches win, and prefixes shared by aliases of one group are fine.
+  A prefix of aliases of different groups is reported with all of its
+  candidates. Lookups walk a prefix tree built when the schema is compiled
+  or loaded, so they cost the length of the argument. Streams take the same
+  flag: set `st.abbrev` after `ext_args_stream_init`. Schemas defined at
+  compile time have no tree and match exactly.
+
+    ext_args_options opts = {.abbrev = true};
+    // "--ver" with "[--verbose] [--version]":
+    // Ambiguous argument "--ver", it may be --verbose, --version
+
+  Clustering:
+
+  With `cluster` set in the options, "-xvf" is read as "-x -v -f" the way
+  POSIX utilities read it. A cluster is split only when it isn't an alias
+  itself and every letter is a single letter alias, otherwise it's matched
+  as usual. The last letter may take the value: "-xvf=a.txt". Each letter
+  is one lookup in a 256-entry table built when the schema is compiled or
+  loaded. Streams take the same flag: set `st.cluster` after
+  `ext_args_stream_init`. Schemas defined at compile time don't cluster.
+
+    ext_args_options opts = {.cluster = true};
+    // "-xvf=a.txt" with "[-x] [-v] [-f=val]" sets all three
+
+  Batch validation:
+
+  `ext_args_parse_batch` checks many argument vectors against one schema.
+  Nothing is filled and no messages are built: every vector gets a status
+  and a bitmask of the given groups in caller provided arrays, one array per
+  kind. Scratch memory is one arena reused for the whole batch, so a batch
+  costs a couple of allocations. `ext_args_batch_error` builds the message
+  of a vector caller wants to report. Response files aren't read.
+
+    int status[N];
+    uint64_t used[N * MAX_WORDS]; // ext_args_batch_words(schema) per vector
+    ext_args_batch_out out = {status, used};
+    int res = ext_args_parse_batch(schema, NULL, N, argcs, argvs, &out);
+    if(res == EXT_ARGS_NO_ERR && status[i] != EXT_ARGS_NO_ERR) {
+      ext_args_batch_error(schema, NULL, argcs[i], argvs[i], &err);
+    }
+
+  With EXT_ARGS_THREADS defined, both where the implementation is compiled
+  and where it's used, `ext_args_parse_batch_mt` takes a number of threads
+  as well. Schemas are never written by a parse, so one is shared by all of
+  them, each thread has its own arena. Vectors are split into equal ranges,
+  a thread out of work steals the back half of a busy one's range. Needs
+  pthreads and GCC or Clang, the allocator must be thread safe.
+
+    res = ext_args_parse_batch_mt(schema, NULL, N, argcs, argvs, &out, 8);
+
+  Subcommands:
+
+  `ext_args_commands_init` takes the global options and a table of
+  subcommands. Names are hashed once and no subcommand schema is compiled
+  until `ext_args_dispatch` selects it, so an invocation pays only for its
+  own subcommand. The subcommand is the first argument not starting with
+  '-': the arguments before it are parsed with the global schema, the rest,
+  starting from the subcommand name, with its own schema.
+
+    static const ext_args_command table[] = {
+      {"commit", "[-m=val] [--amend]"},
+      {"push", "[-f|--force] remote [branch]"}
+    };
+    ext_args_commands *cmds;
+    ext_args_commands_init("[-v] [-C=val]", table, 2, NULL, &cmds, &err);
+
+    int cmd, split;
+    const ext_args_schema *schema;
+    if(ext_args_dispatch(cmds, argc, argv, &cmd, &schema, &split, &err) == EXT_ARGS_NO_ERR) {
+      // "git -v push --force origin": split is 2, cmd is 1
+      sparse(cmds->global, split, argv, &err, &verbose, &dir);
+      sparse(schema, argc - split, argv + split, &err, &force, &remote, &branch);
+    }
+
+  Statistics:
+
+  With EXT_ARGS_STATS defined where the implementation is compiled, parses
+  count their allocations, reallocations, requested bytes, tokens, floats
+  and positionals, and time their phases: lexing, matching, validation and
+  filling. Times are in cycles on x86 and in nanoseconds elsewhere. Set
+  `stats` in the options and the counters of every parse are added to it.
+  Every parse and compile, the schema grammar timed as its own phase, is
+  also added atomically to process-wide totals read by
+  `ext_args_stats_totals`. Without the define nothing is counted and all
+  the counters stay zero. Streams and generated parsers without `stats`
+  aren't counted.
+
+    ext_args_stats st = {0}, total;
+    ext_args_options opts = {.stats = &st};
+    ext_args_parse_ex(schema, &opts, argc, argv, ap, &err);
+    // st.ticks[EXT_ARGS_PHASE_VALIDATE], st.allocs, st.tokens...
+    ext_args_stats_totals(&total);
+
   NOTES
 
   `ext_args` function doesn't mutate `argc` or `argv` arguments. It's safe to call
   it multiple times on the same input.
 
+  Arguments are classified 16 bytes at a time with SSE2 when the compiler
+  targets it. Define EXT_ARGS_NO_SIMD to use the scalar loops.
+
   If you want to totally free all allocated memory, `free` memory allocated for
   errors, variadic positional and floating arguments, nothing else. Like this:
 
@@ -218,13 +638,20 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <setjmp.h>
 #include <stdarg.h>
+#include <limits.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
 
 enum {
   EXT_ARGS_ERR_LEX = 1,
   EXT_ARGS_ERR_PARSE,
-  EXT_ARGS_ERR_MEM
+  EXT_ARGS_ERR_MEM,
+  EXT_ARGS_ERR_TYPE
 };
 
 enum {
@@ -235,30 +662,87 @@ enum {
   EXT_ARGS_TOK_EQL,
   EXT_ARGS_TOK_NAME,
   EXT_ARGS_TOK_FLOAT_ARG,
-  EXT_ARGS_TOK_DOTS
+  EXT_ARGS_TOK_DOTS,
+  EXT_ARGS_TOK_COLON,
+  EXT_ARGS_TOK_AT
 };
 
+// Value types, written after the value name in the schema: "--threads=n:int".
+// The receiver variable type is given in the comments
+enum {
+  EXT_ARGS_T_STR,      // char *, the default
+  EXT_ARGS_T_INT,      // long long
+  EXT_ARGS_T_UINT,     // unsigned long long
+  EXT_ARGS_T_F64,      // double
+  EXT_ARGS_T_SIZE,     // size_t, K/M/G/T suffixes are powers of 1024: "64K", "2G"
+  EXT_ARGS_T_DURATION, // double, seconds. Suffixes ns, us, ms, s, m, h: "250ms"
+  EXT_ARGS_T_BOOL      // bool, true/false, yes/no, on/off, 1/0
+};
+
+// Public functions. With EXT_ARGS_STATIC they're private to the translation
+// unit defining EXT_ARGS_IMPLEMENTATION, not every program uses all of them
+#ifdef EXT_ARGS_STATIC
+#if defined(__GNUC__)
+#define EXT_ARGS_API static __attribute__((unused))
+#else
+#define EXT_ARGS_API static
+#endif
+#define EXT_ARGS_DATA static
+#else
+#if defined(__GNUC__)
+#define EXT_ARGS_API extern __attribute__((visibility("default")))
+#define EXT_ARGS_DATA extern __attribute__((visibility("default")))
+#else
+#define EXT_ARGS_API extern
+#define EXT_ARGS_DATA extern
+#endif
+#endif
+
 #define EXT_ARGS_CAT_(a, b) a ## b
 #define EXT_ARGS_CAT(a, b) EXT_ARGS_CAT_(a, b)
 
 #define EXT_ARGS_DYN_ARY_FIELDS(type, fname) \
   type *fname; \
   int EXT_ARGS_CAT(fname, Count); \
-  int EXT_ARGS_CAT(fname, Allocated)
-
-#define EXT_ARGS_DYN_ARY_SAVE(obj, fname, capacity, buf, val, jbuf) \
+  int EXT_ARGS_CAT(fname, Allocated); \
+  bool EXT_ARGS_CAT(fname, IsInline) // points to storage inside the owner struct
+
+// Inline storage sizes, must be at least 1. Inputs with up to
+// EXT_ARGS_INLINE_ARGS arguments and schemas with up to EXT_ARGS_INLINE_SCHEMA
+// entries of each kind are parsed without touching the heap, only the result
+// arrays and the error strings are allocated
+#ifndef EXT_ARGS_INLINE_ARGS
+#define EXT_ARGS_INLINE_ARGS 32
+#endif
+
+#ifndef EXT_ARGS_INLINE_SCHEMA
+#define EXT_ARGS_INLINE_SCHEMA 16
+#endif
+
+// Growth policy of the dynamic arrays: the new number of elements when
+// `allocated` are used up. Geometric by default, so filling an array costs a
+// linear number of element copies. Define it as `((allocated) + (capacity))`
+// to grow by fixed steps.
+#ifndef EXT_ARGS_GROW
+#define EXT_ARGS_GROW(allocated, capacity) ((allocated) * 2)
+#endif
+
+// `mem` is an allocator, NULL for the default functions
+#define EXT_ARGS_DYN_ARY_SAVE(obj, fname, capacity, buf, val, mem, jbuf) \
   do { \
     if(!obj->fname) { \
       obj->EXT_ARGS_CAT(fname, Allocated) = capacity; \
-      obj->fname = malloc(sizeof(*obj->fname) * obj->EXT_ARGS_CAT(fname, Allocated)); \
+      obj->fname = EXT_ARGS_Alloc(mem, sizeof(*obj->fname) * obj->EXT_ARGS_CAT(fname, Allocated)); \
       if(!obj->fname) { \
         longjmp(jbuf, EXT_ARGS_ERR_MEM); \
       } \
     } \
     \
     if(obj->EXT_ARGS_CAT(fname, Allocated) - obj->EXT_ARGS_CAT(fname, Count) == buf) { \
-      obj->EXT_ARGS_CAT(fname, Allocated) += capacity; \
-      obj->fname = realloc(obj->fname, sizeof(*obj->fname) * obj->EXT_ARGS_CAT(fname, Allocated)); \
+      int allocated_ = EXT_ARGS_GROW(obj->EXT_ARGS_CAT(fname, Allocated), capacity); \
+      obj->fname = EXT_ARGS_Grow(mem, obj->fname, &obj->EXT_ARGS_CAT(fname, IsInline), \
+          sizeof(*obj->fname) * obj->EXT_ARGS_CAT(fname, Allocated), sizeof(*obj->fname) * allocated_); \
+      obj->EXT_ARGS_CAT(fname, Allocated) = allocated_; \
       if(!obj->fname) { \
         longjmp(jbuf, EXT_ARGS_ERR_MEM); \
       } \
@@ -266,16 +750,97 @@ enum {
     obj->fname[obj->EXT_ARGS_CAT(fname, Count)++] = val; \
   } while(0)
 
+// Makes sure the array can take `n` elements without growing
+#define EXT_ARGS_DYN_ARY_RESERVE(obj, fname, n, mem, jbuf) \
+  do { \
+    if(obj->EXT_ARGS_CAT(fname, Allocated) < (n)) { \
+      obj->fname = EXT_ARGS_Grow(mem, obj->fname, &obj->EXT_ARGS_CAT(fname, IsInline), \
+          sizeof(*obj->fname) * obj->EXT_ARGS_CAT(fname, Allocated), sizeof(*obj->fname) * (n)); \
+      obj->EXT_ARGS_CAT(fname, Allocated) = (n); \
+      if(!obj->fname) { \
+        longjmp(jbuf, EXT_ARGS_ERR_MEM); \
+      } \
+    } \
+  } while(0)
+
+// Starts the empty array in `storage`, an array member of the same struct
+#define EXT_ARGS_DYN_ARY_USE_INLINE(obj, fname, storage) \
+  do { \
+    obj->fname = storage; \
+    obj->EXT_ARGS_CAT(fname, Allocated) = sizeof(storage) / sizeof(*(storage)); \
+    obj->EXT_ARGS_CAT(fname, IsInline) = true; \
+  } while(0)
+
+#define EXT_ARGS_DYN_ARY_FREE(obj, fname, mem) \
+  do { \
+    if(!obj->EXT_ARGS_CAT(fname, IsInline)) { \
+      EXT_ARGS_Free(mem, obj->fname); \
+    } \
+  } while(0)
+
 #define EXT_ARGS_PREALLOC 10
 
-static char *ext_args_no_value = "(NO VALUE)";
+// Default nesting limit of response files, "@a" reading "@b" is depth 2
+#ifndef EXT_ARGS_RESPONSE_DEPTH
+#define EXT_ARGS_RESPONSE_DEPTH 8
+#endif
+
+// Initial size of the scratch arena of `ext_args_parse_batch`, doubled
+// when a vector doesn't fit
+#ifndef EXT_ARGS_BATCH_ARENA
+#define EXT_ARGS_BATCH_ARENA 16384
+#endif
+
+// Vectors a batch thread takes from its range at once
+#ifndef EXT_ARGS_BATCH_CHUNK
+#define EXT_ARGS_BATCH_CHUNK 32
+#endif
+
+// Value of the optional value arguments given without one, "-f3"
+EXT_ARGS_DATA char *ext_args_no_value;
+
+// Default allocation functions, used when no allocator is given at runtime
+#ifndef EXT_ARGS_MALLOC
+#define EXT_ARGS_MALLOC(size) malloc(size)
+#define EXT_ARGS_REALLOC(ptr, size) realloc(ptr, size)
+#define EXT_ARGS_FREE(ptr) free(ptr)
+#endif
+
+// Runtime allocator. `ud` is passed as is to every hook. `free` may be NULL
+// when memory is released by other means
+typedef struct {
+  void *(*alloc)(void *ud, size_t size);
+  void *(*realloc)(void *ud, void *ptr, size_t oldSize, size_t size);
+  void (*free)(void *ud, void *ptr);
+  void *ud;
+} ext_args_allocator;
+
+// Caller provided buffer for all the memory of a parse: scratch arrays,
+// result arrays and error strings. Nothing allocated in it has to be freed,
+// `ext_args_arena_reset` releases everything at once.
+typedef struct {
+  char *buf;
+  size_t size;
+  size_t used;
+  size_t last; // offset of the latest allocation, it can grow in place
+} ext_args_arena;
+
+#ifndef EXT_ARGS_ARENA_ALIGN
+#define EXT_ARGS_ARENA_ALIGN 16
+#endif
+
+EXT_ARGS_API void ext_args_arena_init(ext_args_arena *arena, void *buf, size_t size);
+
+EXT_ARGS_API void ext_args_arena_reset(ext_args_arena *arena);
+
+// Allocator which places everything in the arena
+EXT_ARGS_API ext_args_allocator ext_args_arena_allocator(ext_args_arena *arena);
 
 // Positional argument
 typedef struct {
   bool isOptional;
   char *str;
   int len;
-  void *varPtr;
 } EXT_ARGS_PosArg;
 
 // Floating argument
@@ -292,9 +857,10 @@ typedef struct {
   bool isAssignOptional;
   bool isRepeating;
   int aliasCount;
-  void *varPtr;
-  bool isUsed;
-  EXT_ARGS_DYN_ARY_FIELDS(char *, ary);
+  int valType;
+  int seqIdx; // position in the schema, the same as in `sequence`
+  char *env; // environment variable name, not zero terminated
+  int envLen; // 0 when there is none
 } EXT_ARGS_FloatArgsGroup;
 
 typedef struct {
@@ -319,10 +885,14 @@ typedef struct {
 
   struct {
     bool isOptional;
+    int valType;
+    EXT_ARGS_Tok env; // NULL `str` when there is none
   } parsingStates;
 
   EXT_ARGS_Tok lastMatchTok;
 
+  const ext_args_allocator *mem;
+
   // Structure
   EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_PosArg, posArgs);
   EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_FloatArgsGroup, groups);
@@ -330,327 +900,936 @@ typedef struct {
   EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_SequenceElement, sequence);
 
   bool varPosArgsEnabled; // Variadic positional arguments. Indicated with "..." in the schema at the end
-  void *varPosrArgsVarPtr;
 } EXT_ARGS_Parser;
 
-static char *EXT_ARGS_CurrentPos(EXT_ARGS_Parser *prs) {
-  return prs->str;
-}
+typedef struct {
+  char *addr;
+  size_t size;
+  bool isMapped; // otherwise allocated
+} EXT_ARGS_Mapping;
+
+// Prefix tree of the long aliases, the ones starting with "--". Node 0 is
+// the root, 0 also means no node in `child` and `next`. `floatIdx` is the
+// first alias below the node, or EXT_ARGS_TRIE_AMBIGUOUS when the aliases
+// below it belong to different groups
+typedef struct {
+  char c;
+  int child;
+  int next; // sibling
+  int floatIdx;
+} EXT_ARGS_TrieNode;
 
-static void EXT_ARGS_Rollback(EXT_ARGS_Parser *prs, char *str) {
-  prs->str = str;
-}
+#define EXT_ARGS_TRIE_AMBIGUOUS (-2)
 
-static void EXT_ARGS_Consume(EXT_ARGS_Parser *prs) {
-  prs->str++;
-}
+// Compiled schema. Immutable after `ext_args_compile`, so the same schema can
+// be used by any number of `ext_args_parse` calls, including concurrent ones.
+typedef struct {
+  const ext_args_allocator *mem; // points to `allocator` or NULL
+  ext_args_allocator allocator;
 
-static int EXT_ARGS_Distance(EXT_ARGS_Parser *prs, char *str) {
-  return abs(str - prs->str);
-}
+  char *fmt; // own copy, all the `str` fields point into it
 
-static char *EXT_ARGS_TokTypeToName(int type) {
-  switch(type) {
-    case EXT_ARGS_TOK_EOI: return "EOI";
-    case EXT_ARGS_TOK_LBRAK: return "LBRAK";
-    case EXT_ARGS_TOK_RBRAK: return "RBRAK";
-    case EXT_ARGS_TOK_PIPE: return "PIPE";
-    case EXT_ARGS_TOK_EQL: return "EQL";
-    case EXT_ARGS_TOK_NAME: return "NAME";
-    case EXT_ARGS_TOK_FLOAT_ARG: return "FLOAT_ARG";
-    case EXT_ARGS_TOK_DOTS: return "DOTS";
-  }
-  return "UNKNOWN";
-}
+  // Serialized schema read by `ext_args_compile_cached`. `fmt`, `sequence`
+  // and `aliasIndex` point into it
+  EXT_ARGS_Mapping map;
 
-static bool EXT_ARGS_Char(char c, EXT_ARGS_Parser *prs) {
-  if(*prs->str == c) {
-    EXT_ARGS_Consume(prs);
-    return true;
-  }
-  return false;
-}
+  const EXT_ARGS_PosArg *posArgs;
+  int posArgsCount;
+  const EXT_ARGS_FloatArgsGroup *groups;
+  int groupsCount;
+  const EXT_ARGS_FloatArg *floats;
+  int floatsCount;
+  const EXT_ARGS_SequenceElement *sequence;
+  int sequenceCount;
 
-static bool EXT_ARGS_Name(EXT_ARGS_Parser *prs) {
-  char *c = EXT_ARGS_CurrentPos(prs);
-  if(!(*c >= 'a' && *c <= 'z') && !(*c >= 'A' && *c <= 'Z')) {
-    return false;
-  }
-  c++;
+  bool varPosArgsEnabled;
 
-  while((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || (*c == '_' || *c == '-')) {
-    c++;
-  }
+  // Open addressing hash table: alias string -> index in `floats`, -1 for
+  // empty slots. Its size is `aliasIndexMask + 1`, a power of two
+  const int *aliasIndex;
+  unsigned aliasIndexMask;
 
-  if(c == prs->str) {
-    return false;
-  }
+  // For the abbreviations of long aliases, NULL for the static schemas
+  const EXT_ARGS_TrieNode *trie;
 
-  if(*(c - 1) == '-') { // last can't be '-'
-    return false;
-  }
+  // Clusters of single letter aliases: 256 entries, character -> index in
+  // `floats` of its "-c" alias or -1. NULL for the static schemas
+  const int *shortIndex;
 
-  EXT_ARGS_Rollback(prs, c);
-  return true;
-}
+  // Schema specific matcher written by ext_args_gen: alias string -> index
+  // in `floats` or -1. Used instead of the index when set
+  int (*match)(const char *str, int len);
+} ext_args_schema;
 
-static bool EXT_ARGS_ArgFloat(EXT_ARGS_Parser *prs) {
-  char *bk = EXT_ARGS_CurrentPos(prs);
+// Parsing
 
-  while(EXT_ARGS_Char('-', prs));
+// Grammar
 
-  int d = EXT_ARGS_Distance(prs, bk);
-  if(d < 1) {
-    EXT_ARGS_Rollback(prs, bk);
-    return false;
-  }
+// synopsis: decl+ DOTS? EOI
+// decl: arg | LBR arg RBR
+// arg: NAME | FLOAT_ARG (PIPE FLOAT_ARG)* (assignval DOTS? | LBR assignval RBR)?
+// assignval: EQL NAME (COLON NAME)? (AT NAME)?
 
-  if(!EXT_ARGS_Name(prs)) {
-    EXT_ARGS_Rollback(prs, bk);
-    return false;
-  }
+enum {
+  EXT_ARGS_ARG_POS,
+  EXT_ARGS_ARG_GROUP
+};
 
-  return true;
-}
 
-static bool EXT_ARGS_Dots(EXT_ARGS_Parser *prs) {
-  char *bk = EXT_ARGS_CurrentPos(prs);
+// Aliases index
 
-  while(EXT_ARGS_Char('.', prs));
+// FNV-1a
+#define EXT_ARGS_HASH_INIT 2166136261u
 
-  if(EXT_ARGS_Distance(prs, bk) != 3) {
-    EXT_ARGS_Rollback(prs, bk);
-    return false;
-  }
+// Typed values conversion
 
-  return true;
-}
+typedef union {
+  long long i;
+  unsigned long long u;
+  double d;
+  size_t z;
+  bool b;
+} EXT_ARGS_Value;
 
-static bool EXT_ARGS_SkipSpaces(EXT_ARGS_Parser *prs) {
-  char *bk = EXT_ARGS_CurrentPos(prs);
+enum {
+  EXT_ARGS_CONV_OK,
+  EXT_ARGS_CONV_INVALID,
+  EXT_ARGS_CONV_RANGE
+};
 
-  while(EXT_ARGS_Char(' ', prs) || EXT_ARGS_Char('\n', prs) || EXT_ARGS_Char('\t', prs) || EXT_ARGS_Char('\r', prs));
+// Prefix "U" means "User Input"
 
-  if(EXT_ARGS_Distance(prs, bk) == 0) {
-    return false;
-  }
+enum {
+  EXT_ARGS_UTOK_FLOAT,
+  EXT_ARGS_UTOK_EQL,
+  EXT_ARGS_UTOK_VAL,
+  EXT_ARGS_UTOK_EOI
+};
 
-  return true;
-}
+typedef struct {
+  int type;
+  char *str;
+  int len;
+} EXT_ARGS_UTok;
 
-static EXT_ARGS_Tok EXT_ARGS_NextTok(EXT_ARGS_Parser *prs) {
-  while(*prs->str != '\0') {
-    if(EXT_ARGS_SkipSpaces(prs)) {
-      continue;
-    }
+typedef struct {
+  char *str;
+  int len;
+  char *assignVal;
+  int groupIdx; // found during validation, reused when filling the vars
+  EXT_ARGS_Value val; // converted during validation for typed groups
+} EXT_ARGS_UFloatArg;
 
-    char *bk = EXT_ARGS_CurrentPos(prs);
+// Statistics
 
-    if(EXT_ARGS_Char('[', prs)) {
-      return (EXT_ARGS_Tok){EXT_ARGS_TOK_LBRAK, bk, EXT_ARGS_Distance(prs, bk)};
-    }
+// Phases timed in EXT_ARGS_STATS builds
+enum {
+  EXT_ARGS_PHASE_SYNOPSIS, // the schema grammar, compiles only
+  EXT_ARGS_PHASE_LEX,      // setup and the argv lexing loop, response files included
+  EXT_ARGS_PHASE_MATCH,    // tokens to floats and positionals
+  EXT_ARGS_PHASE_VALIDATE, // aliases lookup, values, environment, config, missing arguments
+  EXT_ARGS_PHASE_FILL,     // variables
+  EXT_ARGS_PHASES_COUNT
+};
 
-    if(EXT_ARGS_Char(']', prs)) {
-      return (EXT_ARGS_Tok){EXT_ARGS_TOK_RBRAK, bk, EXT_ARGS_Distance(prs, bk)};
-    }
+// Counters of parses and compiles. They are collected only when
+// EXT_ARGS_STATS is defined where the implementation is compiled, otherwise
+// they stay zero. Every field is a uint64_t
+typedef struct {
+  uint64_t parses;
+  uint64_t compiles;
+  uint64_t ticks[EXT_ARGS_PHASES_COUNT]; // cycles on x86, nanoseconds elsewhere
+  uint64_t allocs;
+  uint64_t reallocs;
+  uint64_t bytes; // requested by the allocations and reallocations
+  uint64_t tokens;
+  uint64_t floats;
+  uint64_t posArgs;
+} ext_args_stats;
+
+// Sums over the process, updated atomically after every parse and compile
+EXT_ARGS_API void ext_args_stats_totals(ext_args_stats *ostats);
+
+#ifdef EXT_ARGS_STATS
+// Allocator of a parse counting into `stats`, it passes the calls to `mem`
+typedef struct {
+  const ext_args_allocator *mem;
+  ext_args_stats *stats;
+} EXT_ARGS_StatsMem;
+#endif
 
-    if(EXT_ARGS_Char('|', prs)) {
-      return (EXT_ARGS_Tok){EXT_ARGS_TOK_PIPE, bk, EXT_ARGS_Distance(prs, bk)};
-    }
+// Array of strings
+typedef struct {
+  EXT_ARGS_DYN_ARY_FIELDS(char *, ary);
+} EXT_ARGS_Ary;
 
-    if(EXT_ARGS_Char('=', prs)) {
-      return (EXT_ARGS_Tok){EXT_ARGS_TOK_EQL, bk, EXT_ARGS_Distance(prs, bk)};
-    }
+// Per parse state of a floating arguments group
+typedef struct {
+  void *varPtr;
+  bool isUsed;
+  int usedCount;
+  EXT_ARGS_DYN_ARY_FIELDS(char *, ary);
+  bool isFromArgs; // given in `argv` or the environment, set before reading a config file
+} EXT_ARGS_GroupState;
 
-    if(EXT_ARGS_Name(prs)) {
-      return (EXT_ARGS_Tok){EXT_ARGS_TOK_NAME, bk, EXT_ARGS_Distance(prs, bk)};
-    }
+typedef struct {
+  jmp_buf jbuf;
+  const ext_args_allocator *mem;
+  ext_args_allocator arenaMem;
 
-    if(EXT_ARGS_ArgFloat(prs)) {
-      return (EXT_ARGS_Tok){EXT_ARGS_TOK_FLOAT_ARG, bk, EXT_ARGS_Distance(prs, bk)};
-    }
+  EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_UTok, tokens);
+  EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_UFloatArg, floats);
+  EXT_ARGS_DYN_ARY_FIELDS(char *, posArgs);
 
-    if(EXT_ARGS_Dots(prs)) {
-      return (EXT_ARGS_Tok){EXT_ARGS_TOK_DOTS, bk, EXT_ARGS_Distance(prs, bk)};
-    }
+  // Indexed the same way as schema's `groups` and `posArgs`
+  EXT_ARGS_GroupState *groups;
+  void **posArgsVarPtrs;
+  void *varPosArgsVarPtr;
+
+  char **envVals; // allocated only for big schemas, see EXT_ARGS_LookupEnv
+  bool deferErr; // messages aren't built, batch validation asks the status only
+
+#ifdef EXT_ARGS_STATS
+  ext_args_stats stats;
+  EXT_ARGS_StatsMem statsMem;
+  ext_args_allocator statsAllocator;
+  int phase;
+  uint64_t lap; // start of the current phase
+#endif
+
+  struct { // inline storage
+    EXT_ARGS_UTok tokens[EXT_ARGS_INLINE_ARGS];
+    EXT_ARGS_UFloatArg floats[EXT_ARGS_INLINE_ARGS];
+    char *posArgs[EXT_ARGS_INLINE_ARGS];
+    EXT_ARGS_GroupState groups[EXT_ARGS_INLINE_SCHEMA];
+    void *posArgsVarPtrs[EXT_ARGS_INLINE_SCHEMA];
+    char *envVals[EXT_ARGS_INLINE_SCHEMA];
+  } inl;
+} EXT_ARGS_Inp;
 
-    prs->errStart = bk;
-    longjmp(prs->jbuf, EXT_ARGS_ERR_LEX);
-  }
+enum {
+  EXT_ARGS_NO_ERR,
+  EXT_ARGS_NO_MEM_ERR,
+  EXT_ARGS_SCHEMA_ERR,
+  EXT_ARGS_INPUT_ERR
+};
 
-  return (EXT_ARGS_Tok){EXT_ARGS_TOK_EOI, NULL, 0};
-}
+EXT_ARGS_API void ext_args_schema_free(ext_args_schema *schema);
 
-// Parsing
+// Inline storage of the schema parser
+typedef struct {
+  EXT_ARGS_PosArg posArgs[EXT_ARGS_INLINE_SCHEMA];
+  EXT_ARGS_FloatArgsGroup groups[EXT_ARGS_INLINE_SCHEMA];
+  EXT_ARGS_FloatArg floats[EXT_ARGS_INLINE_SCHEMA];
+  EXT_ARGS_SequenceElement sequence[EXT_ARGS_INLINE_SCHEMA];
+} EXT_ARGS_ParserInline;
 
-// Grammar
+// The schema and its error string are allocated with `allocator`, NULL for
+// the default functions
+EXT_ARGS_API int ext_args_compile_ex(char *fmt, const ext_args_allocator *allocator,
+    ext_args_schema **oschema, char **oerr);
 
-// synopsis: decl+ DOTS? EOI
-// decl: arg | LBR arg RBR
-// arg: NAME | FLOAT_ARG (PIPE FLOAT_ARG)* (assignval DOTS? | LBR assignval RBR)?
-// assignval: EQL NAME
+EXT_ARGS_API int ext_args_compile(char *fmt, ext_args_schema **oschema, char **oerr);
 
-static bool EXT_ARGS_Match(int tokType, EXT_ARGS_Parser *prs, bool isMandatory) {
-  char *bk = EXT_ARGS_CurrentPos(prs);
+// Serialized schema. Sections follow the header, offsets are from the start
+// of the file and there are no pointers, so it's used in place wherever it's
+// mapped. The layout follows the host ABI, files aren't portable
+#define EXT_ARGS_IMAGE_MAGIC 0x53475241u // "ARGS" in little endian, also detects the byte order
+#define EXT_ARGS_IMAGE_VERSION 1
 
-  EXT_ARGS_Tok t = EXT_ARGS_NextTok(prs);
-  if(t.type == tokType) {
-    prs->lastMatchTok = t;
-    return true;
-  }
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;     // of the whole file
+  uint32_t checksum; // FNV-1a of everything after the header
+  uint32_t posArgsCount, groupsCount, floatsCount, sequenceCount;
+  uint32_t varPosArgsEnabled;
+  uint32_t aliasIndexMask;
+  // Section offsets. `fmt` is the schema string, the strings are its parts
+  uint32_t posArgs, groups, floats, sequence, aliasIndex, fmt;
+} EXT_ARGS_ImageHeader;
 
-  if(isMandatory) {
-    prs->unexpTokType = t.type;
-    prs->expTokType = tokType;
-    prs->errStart = bk;
-    longjmp(prs->jbuf, EXT_ARGS_ERR_PARSE);
-  } else {
-    EXT_ARGS_Rollback(prs, bk);
-    return false;
-  }
-}
+enum {
+  EXT_ARGS_IMAGE_OPTIONAL = 1,
+  EXT_ARGS_IMAGE_ASSIGN = 2,
+  EXT_ARGS_IMAGE_ASSIGN_OPTIONAL = 4,
+  EXT_ARGS_IMAGE_REPEATING = 8
+};
 
-static bool EXT_ARGS_AssignVal(EXT_ARGS_Parser *prs, bool isMandatory) {
-  char *bk = EXT_ARGS_CurrentPos(prs);
+// Rows of the pointer carrying tables, the strings are offsets into `fmt`
+typedef struct {
+  uint32_t isOptional, str, len;
+} EXT_ARGS_ImagePosArg;
 
-  if(!EXT_ARGS_Match(EXT_ARGS_TOK_EQL, prs, isMandatory)) {
-    return false;
-  }
+typedef struct {
+  uint32_t flags, aliasCount, valType, seqIdx, env, envLen;
+} EXT_ARGS_ImageGroup;
 
-  if(!EXT_ARGS_Match(EXT_ARGS_TOK_NAME, prs, isMandatory)) {
-    EXT_ARGS_Rollback(prs, bk);
-    return false;
+typedef struct {
+  uint32_t str, len, groupIdx;
+} EXT_ARGS_ImageFloat;
+
+// Writes a compiled schema to `path` for `ext_args_compile_cached`. The file
+// is written next to `path` and renamed over it, so readers never see a
+// partial one
+EXT_ARGS_API int ext_args_schema_save(const ext_args_schema *schema, const char *path, char **oerr);
+
+// Maps the schema saved at `path` when it was compiled from the same `fmt`
+// and is intact. Otherwise compiles `fmt` and tries to save it for the next
+// time, failures to save are ignored
+EXT_ARGS_API int ext_args_compile_cached(char *fmt, const char *path, const ext_args_allocator *allocator,
+    ext_args_schema **oschema, char **oerr);
+
+// Schemas defined at compile time. `LIST(GROUP, POS)` is an X-macro listing
+// the arguments in the schema order:
+//
+//   GROUP(id, flags, type, env, aliases...) - up to 8 string literal aliases,
+//     `type` is one of EXT_ARGS_T_*, `env` is a variable name or ""
+//   POS(id, flags) - `id` is the name, only EXT_ARGS_F_OPTIONAL applies
+//
+// `EXT_ARGS_DEFINE_SCHEMA(fn, LIST, variadic)` defines
+// `static const ext_args_schema *fn(void)` returning tables placed in
+// read-only data: nothing is lexed or allocated and the schema is never
+// freed. Unlike `ext_args_compile` the tables aren't checked, so they must
+// follow the rules of the string schemas. Aliases are matched without the
+// index, which suits the usual small schemas
+#define EXT_ARGS_F_OPTIONAL 1
+#define EXT_ARGS_F_VALUE 2          // "=val"
+#define EXT_ARGS_F_VALUE_OPTIONAL 4 // "[=val]"
+#define EXT_ARGS_F_REPEATING 8      // "=val...", a value is implied
+
+#define EXT_ARGS_NARGS_(a1, a2, a3, a4, a5, a6, a7, a8, n, ...) n
+#define EXT_ARGS_NARGS(...) EXT_ARGS_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define EXT_ARGS_DEF_FLOAT_1(g, a) {(a), sizeof(a) - 1, (g)},
+#define EXT_ARGS_DEF_FLOAT_2(g, a, ...) EXT_ARGS_DEF_FLOAT_1(g, a) EXT_ARGS_DEF_FLOAT_1(g, __VA_ARGS__)
+#define EXT_ARGS_DEF_FLOAT_3(g, a, ...) EXT_ARGS_DEF_FLOAT_1(g, a) EXT_ARGS_DEF_FLOAT_2(g, __VA_ARGS__)
+#define EXT_ARGS_DEF_FLOAT_4(g, a, ...) EXT_ARGS_DEF_FLOAT_1(g, a) EXT_ARGS_DEF_FLOAT_3(g, __VA_ARGS__)
+#define EXT_ARGS_DEF_FLOAT_5(g, a, ...) EXT_ARGS_DEF_FLOAT_1(g, a) EXT_ARGS_DEF_FLOAT_4(g, __VA_ARGS__)
+#define EXT_ARGS_DEF_FLOAT_6(g, a, ...) EXT_ARGS_DEF_FLOAT_1(g, a) EXT_ARGS_DEF_FLOAT_5(g, __VA_ARGS__)
+#define EXT_ARGS_DEF_FLOAT_7(g, a, ...) EXT_ARGS_DEF_FLOAT_1(g, a) EXT_ARGS_DEF_FLOAT_6(g, __VA_ARGS__)
+#define EXT_ARGS_DEF_FLOAT_8(g, a, ...) EXT_ARGS_DEF_FLOAT_1(g, a) EXT_ARGS_DEF_FLOAT_7(g, __VA_ARGS__)
+
+// Indexes are block scope enumerators, one list per table
+#define EXT_ARGS_DEF_NONE(...)
+#define EXT_ARGS_DEF_GROUP_IDX(id, ...) EXT_ARGS_DEF_G_ ## id,
+#define EXT_ARGS_DEF_POS_IDX(id, ...) EXT_ARGS_DEF_P_ ## id,
+#define EXT_ARGS_DEF_GROUP_SEQ(id, ...) EXT_ARGS_DEF_S_ ## id,
+#define EXT_ARGS_DEF_POS_SEQ(id, ...) EXT_ARGS_DEF_S_ ## id,
+
+#define EXT_ARGS_DEF_GROUP(id, flags, type, env, ...) \
+  {((flags) & EXT_ARGS_F_OPTIONAL) != 0, \
+   ((flags) & (EXT_ARGS_F_VALUE | EXT_ARGS_F_VALUE_OPTIONAL | EXT_ARGS_F_REPEATING)) != 0, \
+   ((flags) & EXT_ARGS_F_VALUE_OPTIONAL) != 0, ((flags) & EXT_ARGS_F_REPEATING) != 0, \
+   EXT_ARGS_NARGS(__VA_ARGS__), (type), EXT_ARGS_DEF_S_ ## id, (env), sizeof(env) - 1},
+#define EXT_ARGS_DEF_FLOATS(id, flags, type, env, ...) \
+  EXT_ARGS_CAT(EXT_ARGS_DEF_FLOAT_, EXT_ARGS_NARGS(__VA_ARGS__))(EXT_ARGS_DEF_G_ ## id, __VA_ARGS__)
+#define EXT_ARGS_DEF_POS(id, flags) {((flags) & EXT_ARGS_F_OPTIONAL) != 0, #id, sizeof(#id) - 1},
+#define EXT_ARGS_DEF_GROUP_ELEM(id, ...) {EXT_ARGS_ARG_GROUP, EXT_ARGS_DEF_G_ ## id},
+#define EXT_ARGS_DEF_POS_ELEM(id, ...) {EXT_ARGS_ARG_POS, EXT_ARGS_DEF_P_ ## id},
+
+// Every table ends with an extra zeroed element, C doesn't allow empty ones
+#define EXT_ARGS_DEF_COUNT(ary) ((int)(sizeof(ary) / sizeof(*(ary))) - 1)
+
+#define EXT_ARGS_DEFINE_SCHEMA(fn, LIST, variadic) \
+  static const ext_args_schema *fn(void) { \
+    enum { LIST(EXT_ARGS_DEF_GROUP_IDX, EXT_ARGS_DEF_NONE) EXT_ARGS_DEF_G_END_ }; \
+    enum { LIST(EXT_ARGS_DEF_NONE, EXT_ARGS_DEF_POS_IDX) EXT_ARGS_DEF_P_END_ }; \
+    enum { LIST(EXT_ARGS_DEF_GROUP_SEQ, EXT_ARGS_DEF_POS_SEQ) EXT_ARGS_DEF_S_END_ }; \
+    static const EXT_ARGS_PosArg posArgs[] = {LIST(EXT_ARGS_DEF_NONE, EXT_ARGS_DEF_POS) {0}}; \
+    static const EXT_ARGS_FloatArgsGroup groups[] = {LIST(EXT_ARGS_DEF_GROUP, EXT_ARGS_DEF_NONE) {0}}; \
+    static const EXT_ARGS_FloatArg floats[] = {LIST(EXT_ARGS_DEF_FLOATS, EXT_ARGS_DEF_NONE) {0}}; \
+    static const EXT_ARGS_SequenceElement sequence[] = { \
+      LIST(EXT_ARGS_DEF_GROUP_ELEM, EXT_ARGS_DEF_POS_ELEM) {0}}; \
+    static const ext_args_schema schema = { \
+      .posArgs = posArgs, .posArgsCount = EXT_ARGS_DEF_COUNT(posArgs), \
+      .groups = groups, .groupsCount = EXT_ARGS_DEF_COUNT(groups), \
+      .floats = floats, .floatsCount = EXT_ARGS_DEF_COUNT(floats), \
+      .sequence = sequence, .sequenceCount = EXT_ARGS_DEF_COUNT(sequence), \
+      .varPosArgsEnabled = (variadic) \
+    }; \
+    return &schema; \
   }
 
-  return true;
-}
+// Field types of the bindings, the sizes alone don't tell a `long long` from
+// a `char *`
+enum {
+  EXT_ARGS_FIELD_ANY,  // EXT_ARGS_BIND, only the size is checked
+  EXT_ARGS_FIELD_STR,  // char *, string values and positional arguments
+  EXT_ARGS_FIELD_LIST, // char **, repeating and variadic arguments
+  EXT_ARGS_FIELD_BOOL, // bool, flags and bool values
+  EXT_ARGS_FIELD_INT,  // long long
+  EXT_ARGS_FIELD_UINT, // unsigned long long
+  EXT_ARGS_FIELD_F64,  // double, f64 and duration values
+  EXT_ARGS_FIELD_SIZE  // size_t
+};
+
+// Binding of a schema argument to a field of a config struct. `name` is any
+// alias of a floating argument, a positional argument name or "..." for the
+// variadic ones. Tables end with EXT_ARGS_BIND_END
+typedef struct {
+  const char *name;
+  size_t offset;
+  size_t size;
+  int type; // EXT_ARGS_FIELD_*
+} ext_args_binding;
+
+#define EXT_ARGS_BIND_AS(type, field, name, ftype) \
+  {(name), offsetof(type, field), sizeof(((type *)0)->field), (ftype)}
+#define EXT_ARGS_BIND(type, field, name) EXT_ARGS_BIND_AS(type, field, name, EXT_ARGS_FIELD_ANY)
+#define EXT_ARGS_BIND_STR(type, field, name) EXT_ARGS_BIND_AS(type, field, name, EXT_ARGS_FIELD_STR)
+#define EXT_ARGS_BIND_LIST(type, field, name) EXT_ARGS_BIND_AS(type, field, name, EXT_ARGS_FIELD_LIST)
+#define EXT_ARGS_BIND_BOOL(type, field, name) EXT_ARGS_BIND_AS(type, field, name, EXT_ARGS_FIELD_BOOL)
+#define EXT_ARGS_BIND_INT(type, field, name) EXT_ARGS_BIND_AS(type, field, name, EXT_ARGS_FIELD_INT)
+#define EXT_ARGS_BIND_UINT(type, field, name) EXT_ARGS_BIND_AS(type, field, name, EXT_ARGS_FIELD_UINT)
+#define EXT_ARGS_BIND_F64(type, field, name) EXT_ARGS_BIND_AS(type, field, name, EXT_ARGS_FIELD_F64)
+#define EXT_ARGS_BIND_SIZE(type, field, name) EXT_ARGS_BIND_AS(type, field, name, EXT_ARGS_FIELD_SIZE)
+#define EXT_ARGS_BIND_END {NULL, 0, 0, 0}
+
+#define EXT_ARGS_UNBOUND ((size_t)-1)
+
+// Bindings resolved against a schema by `ext_args_bind`
+typedef struct {
+  const ext_args_schema *schema;
+  // Field offsets or EXT_ARGS_UNBOUND. Groups first, then positional
+  // arguments, then the variadic ones
+  const size_t *offsets;
+} ext_args_bound;
+
+EXT_ARGS_API void ext_args_bound_free(ext_args_bound *bound);
+
+// Resolves a binding table once, so `ext_args_parse_into` doesn't look
+// anything up. Every name must exist in the schema and every field size must
+// match the argument's variable type, typed bindings must match the type too.
+// Arguments without a binding are skipped
+EXT_ARGS_API int ext_args_bind(const ext_args_schema *schema, const ext_args_binding *table,
+    ext_args_bound **obound, char **oerr);
+
+// Receives values of repeating arguments and variadic positional ones. `id`
+// is the argument's position in the schema, the same as the position of its
+// variable pointer, the variadic positional ones come last. `alias` is the
+// matched alias, not NUL terminated, NULL for positional arguments
+typedef void (*ext_args_emit_fn)(void *ud, int id, const char *alias, int aliasLen, char *val);
+
+// Response files read by a parse. The values point into them, so they're
+// kept until `ext_args_response_files_release`. They're allocated with the
+// options' `allocator`, never in the arena, so resetting it doesn't touch them
+typedef struct {
+  int maxDepth; // 0 means EXT_ARGS_RESPONSE_DEPTH
+
+  const ext_args_allocator *mem; // points to `allocator` or NULL
+  ext_args_allocator allocator;
+  EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_Mapping, maps);
+} ext_args_response_files;
+
+EXT_ARGS_API void ext_args_response_files_release(ext_args_response_files *rf);
+
+typedef struct {
+  char *key; // zero terminated, like `val`
+  int keyLen;
+  char *val; // NULL for a key without "="
+} EXT_ARGS_ConfigEntry;
+
+// Key = value file loaded by `ext_args_config_load`. The values point into it
+typedef struct {
+  const ext_args_allocator *mem; // points to `allocator` or NULL
+  ext_args_allocator allocator;
+  EXT_ARGS_Mapping map;
+  EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_ConfigEntry, entries);
+} ext_args_config;
+
+EXT_ARGS_API void ext_args_config_free(ext_args_config *cfg);
+
+// Reads a config file once, it may be used by any number of parses. Lines
+// are "key = value", "key" alone or comments starting with '#' or ';'.
+// Values may be double quoted to keep the surrounding spaces. The file is
+// split in place, nothing is copied
+EXT_ARGS_API int ext_args_config_load(const char *path, const ext_args_allocator *allocator,
+    ext_args_config **ocfg, char **oerr);
+
+// Optional settings of `ext_args_parse_ex`, zero means default for every field
+typedef struct {
+  // All the scratch memory, the result arrays and the error string are
+  // placed in the arena. When it's exhausted EXT_ARGS_NO_MEM_ERR is returned
+  ext_args_arena *arena;
+
+  // Used for all the allocations when there is no arena. The caller releases
+  // the result arrays and the error string with it
+  const ext_args_allocator *allocator;
+
+  // When set, values of repeating and variadic positional arguments are
+  // passed to it and no arrays are built, their vars are left untouched.
+  // Repeating values come first, then the variadic ones, both in the input order
+  ext_args_emit_fn emit;
+  void *ud;
+
+  // When set, "@path" arguments are replaced with the arguments read from
+  // the file. Release it after the values are used
+  ext_args_response_files *responseFiles;
+
+  // Environment for the "=val@NAME" bindings, `environ` by default
+  char **envp;
+
+  // Values for the arguments not given in `argv` or the environment. Keys
+  // are matched as "--key", then as "-key"
+  const ext_args_config *config;
+
+  // Accept unambiguous prefixes of the "--" aliases, "--verb" for
+  // "--verbose". Exact matches win. Needs a compiled or saved schema
+  bool abbrev;
+
+  // Split "-xvf" into "-x", "-v" and "-f" when it isn't an alias itself and
+  // every letter is one. Needs a compiled or saved schema
+  bool cluster;
+
+  // Counters of the parse are added to it, see `ext_args_stats`
+  ext_args_stats *stats;
+} ext_args_options;
+
+EXT_ARGS_API int ext_args_parse_ex(const ext_args_schema *schema, const ext_args_options *opts,
+    int argc, char *argv[], va_list ap, char **oerr);
+
+// Fills the bound fields of the struct pointed by `dst`
+EXT_ARGS_API int ext_args_parse_into(const ext_args_bound *bound, const ext_args_options *opts,
+    int argc, char *argv[], void *dst, char **oerr);
+
+EXT_ARGS_API int ext_args_parse(const ext_args_schema *schema, int argc, char *argv[], va_list ap, char **oerr);
+
+// Conversions of the typed values, the parsers written by ext_args_gen call
+// them directly. They return EXT_ARGS_CONV_OK, EXT_ARGS_CONV_INVALID or
+// EXT_ARGS_CONV_RANGE, `out` is written only on success
+EXT_ARGS_API int ext_args_conv_int(const char *str, long long *out);
+EXT_ARGS_API int ext_args_conv_uint(const char *str, unsigned long long *out);
+EXT_ARGS_API int ext_args_conv_f64(const char *str, double *out);
+EXT_ARGS_API int ext_args_conv_size(const char *str, size_t *out);
+EXT_ARGS_API int ext_args_conv_duration(const char *str, double *out);
+EXT_ARGS_API int ext_args_conv_bool(const char *str, bool *out);
+
+// Batch validation
+
+// Results of `ext_args_parse_batch` as structure of arrays, entry `i` of each
+// array belongs to vector `i`. The arrays are provided by caller
+typedef struct {
+  int *status; // EXT_ARGS_NO_ERR or the error code of the vector
+  // `ext_args_batch_words` words per vector, bit `g` is set when group `g`
+  // (in the schema order) is given. May be NULL
+  uint64_t *used;
+} ext_args_batch_out;
+
+EXT_ARGS_API int ext_args_batch_words(const ext_args_schema *schema);
+
+// Validates `n` vectors, `argvs[i]` holds `argcs[i]` arguments, without
+// filling variables or building error messages. Scratch memory is one arena
+// from the `opts` allocator reused for the whole batch. Response files and
+// `emit` of the options aren't used. Returns EXT_ARGS_NO_MEM_ERR when the
+// arena can't be allocated, the statuses of the vectors are in `out`
+EXT_ARGS_API int ext_args_parse_batch(const ext_args_schema *schema, const ext_args_options *opts, int n,
+    const int *argcs, char **argvs[], ext_args_batch_out *out);
+
+// Status and message of one vector of a batch, for the vectors caller
+// wants to report
+EXT_ARGS_API int ext_args_batch_error(const ext_args_schema *schema, const ext_args_options *opts,
+    int argc, char *argv[], char **oerr);
+
+#ifdef EXT_ARGS_THREADS
+// `ext_args_parse_batch` spread over `threads` threads, the caller is one of
+// them. The schema is shared, every thread has its own arena. Vectors are
+// dealt out in equal ranges and a thread out of work steals the back half
+// of another one's range. The `opts` allocator must be thread safe
+EXT_ARGS_API int ext_args_parse_batch_mt(const ext_args_schema *schema, const ext_args_options *opts, int n,
+    const int *argcs, char **argvs[], ext_args_batch_out *out, int threads);
+#endif
+
+// Subcommands
+
+// Entry of a subcommand table, {"commit", "[-m=val] [--amend] ..."}
+typedef struct {
+  const char *name;
+  char *fmt;
+} ext_args_command;
+
+// Global options and subcommands made by `ext_args_commands_init`. The schema
+// of a subcommand is compiled when it's dispatched to for the first time
+typedef struct {
+  const ext_args_allocator *mem; // points to `allocator` or NULL
+  ext_args_allocator allocator;
+  ext_args_schema *global;
+  const ext_args_command *commands;
+  int commandsCount;
+  ext_args_schema **schemas; // indexed as `commands`, NULL until compiled
+
+  // Open addressing hash table: name -> index in `commands`, -1 for empty
+  // slots. Its size is `indexMask + 1`, a power of two
+  int *index;
+  unsigned indexMask;
+} ext_args_commands;
+
+EXT_ARGS_API void ext_args_commands_free(ext_args_commands *cmds);
+
+// Compiles the global options and indexes the subcommands by name, nothing
+// else is compiled. `table` must outlive the result
+EXT_ARGS_API int ext_args_commands_init(char *globalFmt, const ext_args_command *table, int count,
+    const ext_args_allocator *allocator, ext_args_commands **ocmds, char **oerr);
+
+// Finds the subcommand, the first argument not starting with '-', compiling
+// its schema when needed. Global options are the `*osplit` arguments before
+// it, the subcommand's own arguments start from its name:
+//
+//   ext_args_parse_ex(cmds->global, opts, split, argv, ap, &err);
+//   ext_args_parse_ex(schema, opts, argc - split, argv + split, ap2, &err);
+EXT_ARGS_API int ext_args_dispatch(ext_args_commands *cmds, int argc, char *argv[], int *ocmd,
+    const ext_args_schema **oschema, int *osplit, char **oerr);
+
+// Streaming parse
 
 enum {
-  EXT_ARGS_ARG_POS,
-  EXT_ARGS_ARG_GROUP
+  EXT_ARGS_STREAM_ANY,
+  EXT_ARGS_STREAM_FLOAT, // a float is pending, it may be followed by "="
+  EXT_ARGS_STREAM_EQL,   // a float and "=" are pending, a value is expected
+  EXT_ARGS_STREAM_END,   // "--" seen, the rest is ignored
+  EXT_ARGS_STREAM_CLOSED // failed or finished, `err` is returned by the later calls
 };
 
-static void EXT_ARGS_SavePosArg(EXT_ARGS_Parser *prs) {
-  EXT_ARGS_DYN_ARY_SAVE(prs, sequence, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_SequenceElement){
-    .type = EXT_ARGS_ARG_POS,
-    .idx = prs->posArgsCount
-  }), prs->jbuf);
+// Push style parser. Memory doesn't depend on the input size: it keeps one
+// pending floating argument and per group flags
+typedef struct {
+  const ext_args_schema *schema;
+  const ext_args_bound *bound;
+  char *dst;
+  ext_args_emit_fn emit;
+  void *ud;
 
-  EXT_ARGS_DYN_ARY_SAVE(prs, posArgs, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_PosArg){
-    .isOptional = prs->parsingStates.isOptional,
-    .str = prs->lastMatchTok.str,
-    .len = prs->lastMatchTok.len
-  }), prs->jbuf);
+  bool abbrev;  // the same as in `ext_args_options`, may be set after init
+  bool cluster; // the same as in `ext_args_options`, may be set after init
+  char **envp;  // the same as in `ext_args_options`, may be set after init
+  const ext_args_config *config; // the same as in `ext_args_options`, may be set after init
+
+  jmp_buf jbuf;
+  int state;
+  int err;
+  EXT_ARGS_UFloatArg pending;
+  int posArgsCount;
+  EXT_ARGS_GroupState *groups;
+  EXT_ARGS_GroupState inlGroups[EXT_ARGS_INLINE_SCHEMA];
+  char **envVals; // allocated by `ext_args_finish` for big schemas
+} ext_args_stream;
+
+// Values go to the fields bound by `bound`, repeating and variadic ones are
+// only passed to `emit`, which may be NULL
+EXT_ARGS_API int ext_args_stream_init(ext_args_stream *st, const ext_args_bound *bound, void *dst,
+    ext_args_emit_fn emit, void *ud);
+
+// Lexes, matches, checks and assigns one argument. `arg` must stay valid as
+// long as the values are used. On error the stream is released. Feeding a
+// finished stream is an error
+EXT_ARGS_API int ext_args_feed(ext_args_stream *st, char *arg, char **oerr);
+
+// Finishes the pending argument, takes the values of the environment and the
+// config file for the arguments not fed, checks the required ones and assigns
+// the defaults. Always releases the stream, call it to abandon a stream too
+EXT_ARGS_API int ext_args_finish(ext_args_stream *st, char **oerr);
+
+EXT_ARGS_API int ext_args(int argc, char *argv[], char *fmt, va_list ap, char **oerr);
+
+#endif // INCLUDE_EXT_ARGS_H
+
+#if defined(EXT_ARGS_IMPLEMENTATION) && !defined(EXT_ARGS_IMPLEMENTATION_DONE)
+#define EXT_ARGS_IMPLEMENTATION_DONE
+
+// Response files are memory mapped on POSIX systems and read with stdio
+// elsewhere or when EXT_ARGS_NO_MMAP is defined
+#if !defined(EXT_ARGS_NO_MMAP) && !(defined(__unix__) || defined(__APPLE__))
+#define EXT_ARGS_NO_MMAP
+#endif
+
+#ifdef _WIN32
+#define EXT_ARGS_ENVIRON _environ
+#else
+extern char **environ;
+#define EXT_ARGS_ENVIRON environ
+#endif
+
+// Arguments are classified 16 bytes at a time with SSE2 where the compiler
+// targets it, define EXT_ARGS_NO_SIMD for the scalar loops
+#if !defined(EXT_ARGS_NO_SIMD) && defined(__SSE2__) && defined(__GNUC__)
+#define EXT_ARGS_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifndef EXT_ARGS_NO_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Statistics are timed with rdtsc on x86 and with the C clocks elsewhere
+#ifdef EXT_ARGS_STATS
+#include <time.h>
+#endif
+
+// Multi-threaded batches need pthreads and the GCC atomic builtins
+#ifdef EXT_ARGS_THREADS
+#include <pthread.h>
+#endif
+
+#ifdef EXT_ARGS_STATIC
+static
+#endif
+char *ext_args_no_value = "(NO VALUE)";
+
+EXT_ARGS_API void ext_args_arena_init(ext_args_arena *arena, void *buf, size_t size) {
+  *arena = (ext_args_arena){.buf = buf, .size = size};
 }
 
-static int EXT_ARGS_SaveFloatArg(EXT_ARGS_Parser *prs, int groupIdx) {
-  int bkIdx = prs->floatsCount;
+EXT_ARGS_API void ext_args_arena_reset(ext_args_arena *arena) {
+  arena->used = 0;
+  arena->last = 0;
+}
 
-  EXT_ARGS_DYN_ARY_SAVE(prs, floats, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_FloatArg){
-    .str = prs->lastMatchTok.str,
-    .len = prs->lastMatchTok.len,
-    .groupIdx = groupIdx
-  }), prs->jbuf);
+static void *EXT_ARGS_ArenaAlloc(void *ud, size_t size) {
+  ext_args_arena *arena = ud;
 
-  return bkIdx;
+  uintptr_t addr = (uintptr_t)(arena->buf + arena->used);
+  size_t pad = (EXT_ARGS_ARENA_ALIGN - addr % EXT_ARGS_ARENA_ALIGN) % EXT_ARGS_ARENA_ALIGN;
+  size_t start = arena->used + pad;
+  if(start > arena->size || arena->size - start < size) {
+    return NULL;
+  }
+  arena->last = start;
+  arena->used = start + size;
+  return arena->buf + start;
 }
 
-static void EXT_ARGS_SaveGroup(EXT_ARGS_Parser *prs, bool hasAssign, bool isRepeating, int aliasCount) {
-  EXT_ARGS_DYN_ARY_SAVE(prs, sequence, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_SequenceElement){
-    .type = EXT_ARGS_ARG_GROUP,
-    .idx = prs->groupsCount
-  }), prs->jbuf);
+static void *EXT_ARGS_ArenaRealloc(void *ud, void *ptr, size_t oldSize, size_t size) {
+  ext_args_arena *arena = ud;
 
-  EXT_ARGS_DYN_ARY_SAVE(prs, groups, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_FloatArgsGroup){
-    .isOptional = prs->parsingStates.isOptional,
-    .hasAssign = hasAssign,
-    .isRepeating = isRepeating,
-    .aliasCount = aliasCount
-  }), prs->jbuf);
+  if(ptr && (char *)ptr == arena->buf + arena->last) {
+    if(arena->size - arena->last >= size) {
+      arena->used = arena->last + size;
+      return ptr;
+    }
+  }
+
+  void *p = EXT_ARGS_ArenaAlloc(arena, size);
+  if(p && ptr) {
+    memcpy(p, ptr, oldSize < size ? oldSize : size);
+  }
+  return p;
 }
 
-static bool EXT_ARGS_Arg(EXT_ARGS_Parser *prs, bool isMandatory) {
-  if(EXT_ARGS_Match(EXT_ARGS_TOK_NAME, prs, false)) {
-    EXT_ARGS_SavePosArg(prs);
-    return true;
+EXT_ARGS_API ext_args_allocator ext_args_arena_allocator(ext_args_arena *arena) {
+  return (ext_args_allocator){
+    .alloc = EXT_ARGS_ArenaAlloc,
+    .realloc = EXT_ARGS_ArenaRealloc,
+    .ud = arena
+  };
+}
+
+// `mem` is NULL for the default functions
+
+static void *EXT_ARGS_Alloc(const ext_args_allocator *mem, size_t size) {
+  if(!mem) {
+    return EXT_ARGS_MALLOC(size);
   }
+  return mem->alloc(mem->ud, size);
+}
 
-  if(!EXT_ARGS_Match(EXT_ARGS_TOK_FLOAT_ARG, prs, isMandatory)) {
-    return false;
+static void *EXT_ARGS_Calloc(const ext_args_allocator *mem, size_t count, size_t size) {
+  void *p = EXT_ARGS_Alloc(mem, count * size);
+  if(p) {
+    memset(p, 0, count * size);
   }
+  return p;
+}
 
-  int groupIdx = prs->groupsCount;
-  int floatBk = EXT_ARGS_SaveFloatArg(prs, groupIdx);
+static void *EXT_ARGS_Realloc(const ext_args_allocator *mem, void *ptr, size_t oldSize, size_t size) {
+  if(!mem) {
+    return EXT_ARGS_REALLOC(ptr, size);
+  }
+  return mem->realloc(mem->ud, ptr, oldSize, size);
+}
 
-  char *bk = EXT_ARGS_CurrentPos(prs);
-  int aliasCount = 1;
+static void EXT_ARGS_Free(const ext_args_allocator *mem, void *ptr) {
+  if(!ptr) {
+    return;
+  }
+  if(!mem) {
+    EXT_ARGS_FREE(ptr);
+  } else if(mem->free) {
+    mem->free(mem->ud, ptr);
+  }
+}
 
-  while(EXT_ARGS_Match(EXT_ARGS_TOK_PIPE, prs, false)) {
-    if(!EXT_ARGS_Match(EXT_ARGS_TOK_FLOAT_ARG, prs, isMandatory)) {
-      EXT_ARGS_Rollback(prs, bk);
-      prs->floatsCount = floatBk;
-      return false;
+#ifdef EXT_ARGS_STATS
+static ext_args_stats EXT_ARGS_Totals;
+
+static uint64_t EXT_ARGS_Now(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  return (uint64_t)clock() * (1000000000 / CLOCKS_PER_SEC);
+#endif
+}
+
+// Adds `st` to `dst`, field by field, they are all uint64_t
+static void EXT_ARGS_StatsAdd(ext_args_stats *dst, const ext_args_stats *st, bool atomic) {
+  uint64_t *d = (uint64_t *)dst;
+  const uint64_t *v = (const uint64_t *)st;
+  for(size_t i = 0; i < sizeof(*st) / sizeof(uint64_t); i++) {
+    if(atomic) {
+      __atomic_fetch_add(&d[i], v[i], __ATOMIC_RELAXED);
+    } else {
+      d[i] += v[i];
     }
-    EXT_ARGS_SaveFloatArg(prs, groupIdx);
-    aliasCount++;
   }
+}
 
-  bool hasAssign = false;
-  bool isRepeating = false;
+static void *EXT_ARGS_StatsAlloc(void *ud, size_t size) {
+  EXT_ARGS_StatsMem *sm = ud;
+  sm->stats->allocs++;
+  sm->stats->bytes += size;
+  return EXT_ARGS_Alloc(sm->mem, size);
+}
 
-  if(EXT_ARGS_AssignVal(prs, false)) {
-    hasAssign = true;
-    if(EXT_ARGS_Match(EXT_ARGS_TOK_DOTS, prs, false)) {
-      isRepeating = true;
-    }
-    EXT_ARGS_SaveGroup(prs, hasAssign, isRepeating, aliasCount);
-    return true;
+static void *EXT_ARGS_StatsRealloc(void *ud, void *ptr, size_t oldSize, size_t size) {
+  EXT_ARGS_StatsMem *sm = ud;
+  sm->stats->reallocs++;
+  sm->stats->bytes += size;
+  return EXT_ARGS_Realloc(sm->mem, ptr, oldSize, size);
+}
+
+static void EXT_ARGS_StatsFree(void *ud, void *ptr) {
+  EXT_ARGS_StatsMem *sm = ud;
+  EXT_ARGS_Free(sm->mem, ptr);
+}
+#endif
+
+EXT_ARGS_API void ext_args_stats_totals(ext_args_stats *ostats) {
+  *ostats = (ext_args_stats){0};
+#ifdef EXT_ARGS_STATS
+  uint64_t *d = (uint64_t *)ostats;
+  uint64_t *t = (uint64_t *)&EXT_ARGS_Totals;
+  for(size_t i = 0; i < sizeof(*ostats) / sizeof(uint64_t); i++) {
+    d[i] = __atomic_load_n(&t[i], __ATOMIC_RELAXED);
   }
+#endif
+}
 
-  EXT_ARGS_SaveGroup(prs, hasAssign, isRepeating, aliasCount);
+// Moves a dynamic array to a bigger block. Arrays in inline storage are
+// copied out instead of being reallocated
+static void *EXT_ARGS_Grow(const ext_args_allocator *mem, void *ptr, bool *isInline, size_t oldSize, size_t size) {
+  if(!*isInline) {
+    return EXT_ARGS_Realloc(mem, ptr, oldSize, size);
+  }
 
-  bk = EXT_ARGS_CurrentPos(prs); // new backup point
+  void *p = EXT_ARGS_Alloc(mem, size);
+  if(p) {
+    memcpy(p, ptr, oldSize);
+    *isInline = false;
+  }
+  return p;
+}
 
-  if(!EXT_ARGS_Match(EXT_ARGS_TOK_LBRAK, prs, false)) {
-    EXT_ARGS_Rollback(prs, bk);
-    return true;
+// Heap copy of `count` elements of `size` bytes. NULL for empty arrays
+static void *EXT_ARGS_Dup(const ext_args_allocator *mem, const void *ptr, int count, size_t size) {
+  if(count == 0) {
+    return NULL;
   }
+  void *p = EXT_ARGS_Alloc(mem, count * size);
+  if(p) {
+    memcpy(p, ptr, count * size);
+  }
+  return p;
+}
 
-  if(!EXT_ARGS_AssignVal(prs, false)) {
-    EXT_ARGS_Rollback(prs, bk);
-    return true;
+static char *EXT_ARGS_CurrentPos(EXT_ARGS_Parser *prs) {
+  return prs->str;
+}
+
+static void EXT_ARGS_Rollback(EXT_ARGS_Parser *prs, char *str) {
+  prs->str = str;
+}
+
+static void EXT_ARGS_Consume(EXT_ARGS_Parser *prs) {
+  prs->str++;
+}
+
+static int EXT_ARGS_Distance(EXT_ARGS_Parser *prs, char *str) {
+  return abs(str - prs->str);
+}
+
+static char *EXT_ARGS_TokTypeToName(int type) {
+  switch(type) {
+    case EXT_ARGS_TOK_EOI: return "EOI";
+    case EXT_ARGS_TOK_LBRAK: return "LBRAK";
+    case EXT_ARGS_TOK_RBRAK: return "RBRAK";
+    case EXT_ARGS_TOK_PIPE: return "PIPE";
+    case EXT_ARGS_TOK_EQL: return "EQL";
+    case EXT_ARGS_TOK_NAME: return "NAME";
+    case EXT_ARGS_TOK_FLOAT_ARG: return "FLOAT_ARG";
+    case EXT_ARGS_TOK_DOTS: return "DOTS";
+    case EXT_ARGS_TOK_COLON: return "COLON";
+    case EXT_ARGS_TOK_AT: return "AT";
   }
+  return "UNKNOWN";
+}
 
-  if(!EXT_ARGS_Match(EXT_ARGS_TOK_RBRAK, prs, false)) {
-    EXT_ARGS_Rollback(prs, bk);
+static bool EXT_ARGS_Char(char c, EXT_ARGS_Parser *prs) {
+  if(*prs->str == c) {
+    EXT_ARGS_Consume(prs);
     return true;
   }
+  return false;
+}
 
-  prs->groups[groupIdx].hasAssign = true;
-  prs->groups[groupIdx].isAssignOptional = true;
+static bool EXT_ARGS_IsAlpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
 
-  return true;
+static bool EXT_ARGS_IsNameChar(char c) {
+  return EXT_ARGS_IsAlpha(c) || (c >= '0' && c <= '9') || c == '_' || c == '-';
 }
 
-static bool EXT_ARGS_Decl(EXT_ARGS_Parser *prs, bool isMandatory) {
-  prs->parsingStates.isOptional = false;
-  if(EXT_ARGS_Arg(prs, false)) {
-    return true;
+static bool EXT_ARGS_Name(EXT_ARGS_Parser *prs) {
+  char *c = EXT_ARGS_CurrentPos(prs);
+  if(!EXT_ARGS_IsAlpha(*c)) {
+    return false;
   }
+  c++;
 
-  char *bk = EXT_ARGS_CurrentPos(prs);
+  while(EXT_ARGS_IsNameChar(*c)) {
+    c++;
+  }
 
-  if(!EXT_ARGS_Match(EXT_ARGS_TOK_LBRAK, prs, isMandatory)) {
+  if(c == prs->str) {
     return false;
   }
 
-  prs->parsingStates.isOptional = true;
-  if(!EXT_ARGS_Arg(prs, isMandatory)) {
+  if(*(c - 1) == '-') { // last can't be '-'
+    return false;
+  }
+
+  EXT_ARGS_Rollback(prs, c);
+  return true;
+}
+
+static bool EXT_ARGS_ArgFloat(EXT_ARGS_Parser *prs) {
+  char *bk = EXT_ARGS_CurrentPos(prs);
+
+  while(EXT_ARGS_Char('-', prs));
+
+  int d = EXT_ARGS_Distance(prs, bk);
+  if(d < 1) {
     EXT_ARGS_Rollback(prs, bk);
     return false;
   }
 
-  if(!EXT_ARGS_Match(EXT_ARGS_TOK_RBRAK, prs, isMandatory)) {
+  if(!EXT_ARGS_Name(prs)) {
     EXT_ARGS_Rollback(prs, bk);
     return false;
   }
@@ -658,449 +1837,3220 @@ static bool EXT_ARGS_Decl(EXT_ARGS_Parser *prs, bool isMandatory) {
   return true;
 }
 
-static void EXT_ARGS_Synopsis(EXT_ARGS_Parser *prs) {
-  while(EXT_ARGS_Decl(prs, false));
-  if(EXT_ARGS_Match(EXT_ARGS_TOK_DOTS, prs, false)) {
-    prs->varPosArgsEnabled = true;
+static bool EXT_ARGS_Dots(EXT_ARGS_Parser *prs) {
+  char *bk = EXT_ARGS_CurrentPos(prs);
+
+  while(EXT_ARGS_Char('.', prs));
+
+  if(EXT_ARGS_Distance(prs, bk) != 3) {
+    EXT_ARGS_Rollback(prs, bk);
+    return false;
   }
-  EXT_ARGS_Match(EXT_ARGS_TOK_EOI, prs, true);
+
+  return true;
 }
 
+static bool EXT_ARGS_SkipSpaces(EXT_ARGS_Parser *prs) {
+  char *bk = EXT_ARGS_CurrentPos(prs);
 
-// Prefix "U" means "User Input"
+  while(EXT_ARGS_Char(' ', prs) || EXT_ARGS_Char('\n', prs) || EXT_ARGS_Char('\t', prs) || EXT_ARGS_Char('\r', prs));
 
-enum {
-  EXT_ARGS_UTOK_FLOAT,
-  EXT_ARGS_UTOK_EQL,
-  EXT_ARGS_UTOK_VAL,
-  EXT_ARGS_UTOK_EOI
-};
+  if(EXT_ARGS_Distance(prs, bk) == 0) {
+    return false;
+  }
 
-typedef struct {
-  int type;
-  char *str;
-  int len;
-} EXT_ARGS_UTok;
+  return true;
+}
 
-typedef struct {
-  char *str;
-  int len;
-  char *assignVal;
-} EXT_ARGS_UFloatArg;
+static EXT_ARGS_Tok EXT_ARGS_NextTok(EXT_ARGS_Parser *prs) {
+  while(*prs->str != '\0') {
+    if(EXT_ARGS_SkipSpaces(prs)) {
+      continue;
+    }
+
+    char *bk = EXT_ARGS_CurrentPos(prs);
+
+    if(EXT_ARGS_Char('[', prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_LBRAK, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    if(EXT_ARGS_Char(']', prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_RBRAK, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    if(EXT_ARGS_Char('|', prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_PIPE, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    if(EXT_ARGS_Char('=', prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_EQL, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    if(EXT_ARGS_Char(':', prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_COLON, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    if(EXT_ARGS_Char('@', prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_AT, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    if(EXT_ARGS_Name(prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_NAME, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    if(EXT_ARGS_ArgFloat(prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_FLOAT_ARG, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    if(EXT_ARGS_Dots(prs)) {
+      return (EXT_ARGS_Tok){EXT_ARGS_TOK_DOTS, bk, EXT_ARGS_Distance(prs, bk)};
+    }
+
+    prs->errStart = bk;
+    longjmp(prs->jbuf, EXT_ARGS_ERR_LEX);
+  }
+
+  return (EXT_ARGS_Tok){EXT_ARGS_TOK_EOI, NULL, 0};
+}
+
+static bool EXT_ARGS_Match(int tokType, EXT_ARGS_Parser *prs, bool isMandatory) {
+  char *bk = EXT_ARGS_CurrentPos(prs);
+
+  EXT_ARGS_Tok t = EXT_ARGS_NextTok(prs);
+  if(t.type == tokType) {
+    prs->lastMatchTok = t;
+    return true;
+  }
+
+  if(isMandatory) {
+    prs->unexpTokType = t.type;
+    prs->expTokType = tokType;
+    prs->errStart = bk;
+    longjmp(prs->jbuf, EXT_ARGS_ERR_PARSE);
+  } else {
+    EXT_ARGS_Rollback(prs, bk);
+    return false;
+  }
+}
+
+static int EXT_ARGS_TypeByName(EXT_ARGS_Tok t) {
+  static const char *names[] = {
+    [EXT_ARGS_T_STR] = "str",
+    [EXT_ARGS_T_INT] = "int",
+    [EXT_ARGS_T_UINT] = "uint",
+    [EXT_ARGS_T_F64] = "f64",
+    [EXT_ARGS_T_SIZE] = "size",
+    [EXT_ARGS_T_DURATION] = "duration",
+    [EXT_ARGS_T_BOOL] = "bool"
+  };
+
+  for(int i = 0; i < (int)(sizeof(names) / sizeof(*names)); i++) {
+    if((int)strlen(names[i]) == t.len && strncmp(names[i], t.str, t.len) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static bool EXT_ARGS_AssignVal(EXT_ARGS_Parser *prs, bool isMandatory) {
+  char *bk = EXT_ARGS_CurrentPos(prs);
+
+  if(!EXT_ARGS_Match(EXT_ARGS_TOK_EQL, prs, isMandatory)) {
+    return false;
+  }
+
+  if(!EXT_ARGS_Match(EXT_ARGS_TOK_NAME, prs, isMandatory)) {
+    EXT_ARGS_Rollback(prs, bk);
+    return false;
+  }
+
+  prs->parsingStates.valType = EXT_ARGS_T_STR;
+  if(EXT_ARGS_Match(EXT_ARGS_TOK_COLON, prs, false)) {
+    EXT_ARGS_Match(EXT_ARGS_TOK_NAME, prs, true);
+    prs->parsingStates.valType = EXT_ARGS_TypeByName(prs->lastMatchTok);
+    if(prs->parsingStates.valType == -1) {
+      prs->errStart = prs->lastMatchTok.str;
+      longjmp(prs->jbuf, EXT_ARGS_ERR_TYPE);
+    }
+  }
+
+  prs->parsingStates.env = (EXT_ARGS_Tok){0};
+  if(EXT_ARGS_Match(EXT_ARGS_TOK_AT, prs, false)) {
+    EXT_ARGS_Match(EXT_ARGS_TOK_NAME, prs, true);
+    prs->parsingStates.env = prs->lastMatchTok;
+  }
+
+  return true;
+}
+
+static void EXT_ARGS_SavePosArg(EXT_ARGS_Parser *prs) {
+  EXT_ARGS_DYN_ARY_SAVE(prs, sequence, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_SequenceElement){
+    .type = EXT_ARGS_ARG_POS,
+    .idx = prs->posArgsCount
+  }), prs->mem, prs->jbuf);
+
+  EXT_ARGS_DYN_ARY_SAVE(prs, posArgs, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_PosArg){
+    .isOptional = prs->parsingStates.isOptional,
+    .str = prs->lastMatchTok.str,
+    .len = prs->lastMatchTok.len
+  }), prs->mem, prs->jbuf);
+}
+
+static int EXT_ARGS_SaveFloatArg(EXT_ARGS_Parser *prs, int groupIdx) {
+  int bkIdx = prs->floatsCount;
+
+  EXT_ARGS_DYN_ARY_SAVE(prs, floats, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_FloatArg){
+    .str = prs->lastMatchTok.str,
+    .len = prs->lastMatchTok.len,
+    .groupIdx = groupIdx
+  }), prs->mem, prs->jbuf);
+
+  return bkIdx;
+}
+
+// Value type and environment variable come from the parsing states for groups with assign
+static void EXT_ARGS_SaveGroup(EXT_ARGS_Parser *prs, bool hasAssign, bool isRepeating, int aliasCount) {
+  EXT_ARGS_DYN_ARY_SAVE(prs, sequence, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_SequenceElement){
+    .type = EXT_ARGS_ARG_GROUP,
+    .idx = prs->groupsCount
+  }), prs->mem, prs->jbuf);
+
+  EXT_ARGS_DYN_ARY_SAVE(prs, groups, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_FloatArgsGroup){
+    .isOptional = prs->parsingStates.isOptional,
+    .hasAssign = hasAssign,
+    .isRepeating = isRepeating,
+    .aliasCount = aliasCount,
+    .valType = hasAssign ? prs->parsingStates.valType : EXT_ARGS_T_STR,
+    .seqIdx = prs->sequenceCount - 1,
+    .env = hasAssign ? prs->parsingStates.env.str : NULL,
+    .envLen = hasAssign ? prs->parsingStates.env.len : 0
+  }), prs->mem, prs->jbuf);
+}
+
+static bool EXT_ARGS_Arg(EXT_ARGS_Parser *prs, bool isMandatory) {
+  if(EXT_ARGS_Match(EXT_ARGS_TOK_NAME, prs, false)) {
+    EXT_ARGS_SavePosArg(prs);
+    return true;
+  }
+
+  if(!EXT_ARGS_Match(EXT_ARGS_TOK_FLOAT_ARG, prs, isMandatory)) {
+    return false;
+  }
+
+  int groupIdx = prs->groupsCount;
+  int floatBk = EXT_ARGS_SaveFloatArg(prs, groupIdx);
+
+  char *bk = EXT_ARGS_CurrentPos(prs);
+  int aliasCount = 1;
+
+  while(EXT_ARGS_Match(EXT_ARGS_TOK_PIPE, prs, false)) {
+    if(!EXT_ARGS_Match(EXT_ARGS_TOK_FLOAT_ARG, prs, isMandatory)) {
+      EXT_ARGS_Rollback(prs, bk);
+      prs->floatsCount = floatBk;
+      return false;
+    }
+    EXT_ARGS_SaveFloatArg(prs, groupIdx);
+    aliasCount++;
+  }
+
+  bool hasAssign = false;
+  bool isRepeating = false;
+
+  if(EXT_ARGS_AssignVal(prs, false)) {
+    hasAssign = true;
+    if(EXT_ARGS_Match(EXT_ARGS_TOK_DOTS, prs, false)) {
+      isRepeating = true;
+    }
+    EXT_ARGS_SaveGroup(prs, hasAssign, isRepeating, aliasCount);
+    return true;
+  }
+
+  EXT_ARGS_SaveGroup(prs, hasAssign, isRepeating, aliasCount);
+
+  bk = EXT_ARGS_CurrentPos(prs); // new backup point
+
+  if(!EXT_ARGS_Match(EXT_ARGS_TOK_LBRAK, prs, false)) {
+    EXT_ARGS_Rollback(prs, bk);
+    return true;
+  }
+
+  if(!EXT_ARGS_AssignVal(prs, false)) {
+    EXT_ARGS_Rollback(prs, bk);
+    return true;
+  }
+
+  if(!EXT_ARGS_Match(EXT_ARGS_TOK_RBRAK, prs, false)) {
+    EXT_ARGS_Rollback(prs, bk);
+    return true;
+  }
+
+  prs->groups[groupIdx].hasAssign = true;
+  prs->groups[groupIdx].isAssignOptional = true;
+  prs->groups[groupIdx].valType = prs->parsingStates.valType;
+  prs->groups[groupIdx].env = prs->parsingStates.env.str;
+  prs->groups[groupIdx].envLen = prs->parsingStates.env.len;
+
+  return true;
+}
+
+static bool EXT_ARGS_Decl(EXT_ARGS_Parser *prs, bool isMandatory) {
+  prs->parsingStates.isOptional = false;
+  if(EXT_ARGS_Arg(prs, false)) {
+    return true;
+  }
+
+  char *bk = EXT_ARGS_CurrentPos(prs);
+
+  if(!EXT_ARGS_Match(EXT_ARGS_TOK_LBRAK, prs, isMandatory)) {
+    return false;
+  }
+
+  prs->parsingStates.isOptional = true;
+  if(!EXT_ARGS_Arg(prs, isMandatory)) {
+    EXT_ARGS_Rollback(prs, bk);
+    return false;
+  }
+
+  if(!EXT_ARGS_Match(EXT_ARGS_TOK_RBRAK, prs, isMandatory)) {
+    EXT_ARGS_Rollback(prs, bk);
+    return false;
+  }
+
+  return true;
+}
+
+static void EXT_ARGS_Synopsis(EXT_ARGS_Parser *prs) {
+  while(EXT_ARGS_Decl(prs, false));
+  if(EXT_ARGS_Match(EXT_ARGS_TOK_DOTS, prs, false)) {
+    prs->varPosArgsEnabled = true;
+  }
+  EXT_ARGS_Match(EXT_ARGS_TOK_EOI, prs, true);
+}
+
+// Continues hashing from `h`, so a string can be hashed in parts
+static unsigned EXT_ARGS_HashMore(unsigned h, const char *str, int len) {
+  for(int i = 0; i < len; i++) {
+    h ^= (unsigned char)str[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static unsigned EXT_ARGS_Hash(const char *str, int len) {
+  return EXT_ARGS_HashMore(EXT_ARGS_HASH_INIT, str, len);
+}
+
+static int *EXT_ARGS_BuildAliasIndex(const ext_args_allocator *mem, const EXT_ARGS_FloatArg *floats,
+    int floatsCount, unsigned *omask) {
+  unsigned size = 8;
+  while(size < (unsigned)floatsCount * 2) {
+    size *= 2;
+  }
+
+  int *index = EXT_ARGS_Alloc(mem, sizeof(*index) * size);
+  if(!index) {
+    return NULL;
+  }
+  memset(index, -1, sizeof(*index) * size);
+
+  unsigned mask = size - 1;
+  for(int i = 0; i < floatsCount; i++) {
+    EXT_ARGS_FloatArg f = floats[i];
+    unsigned slot = EXT_ARGS_Hash(f.str, f.len) & mask;
+    for(;;) {
+      int fi = index[slot];
+      if(fi == -1) {
+        index[slot] = i;
+        break;
+      }
+      if(floats[fi].len == f.len && strncmp(floats[fi].str, f.str, f.len) == 0) {
+        break; // the same alias twice, the first one wins
+      }
+      slot = (slot + 1) & mask;
+    }
+  }
+
+  *omask = mask;
+  return index;
+}
+
+// Returns index in `floats` or -1
+static int EXT_ARGS_FindFloat(const ext_args_schema *schema, const char *str, int len) {
+  if(schema->match) {
+    return schema->match(str, len);
+  }
+  if(!schema->aliasIndex) { // small schemas
+    for(int i = 0; i < schema->floatsCount; i++) {
+      EXT_ARGS_FloatArg f = schema->floats[i];
+      if(f.len == len && strncmp(f.str, str, len) == 0) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  unsigned slot = EXT_ARGS_Hash(str, len) & schema->aliasIndexMask;
+  for(;;) {
+    int fi = schema->aliasIndex[slot];
+    if(fi == -1) {
+      return -1;
+    }
+    EXT_ARGS_FloatArg f = schema->floats[fi];
+    if(f.len == len && strncmp(f.str, str, len) == 0) {
+      return fi;
+    }
+    slot = (slot + 1) & schema->aliasIndexMask;
+  }
+}
+
+static EXT_ARGS_TrieNode *EXT_ARGS_BuildTrie(const ext_args_allocator *mem, const EXT_ARGS_FloatArg *floats,
+    int count) {
+  size_t capacity = 1;
+  for(int i = 0; i < count; i++) {
+    if(floats[i].len > 2 && floats[i].str[0] == '-' && floats[i].str[1] == '-') {
+      capacity += floats[i].len;
+    }
+  }
+  EXT_ARGS_TrieNode *trie = EXT_ARGS_Alloc(mem, sizeof(*trie) * capacity);
+  if(!trie) {
+    return NULL;
+  }
+
+  trie[0] = (EXT_ARGS_TrieNode){.floatIdx = EXT_ARGS_TRIE_AMBIGUOUS};
+  int n = 1;
+  for(int i = 0; i < count; i++) {
+    EXT_ARGS_FloatArg f = floats[i];
+    if(f.len <= 2 || f.str[0] != '-' || f.str[1] != '-') {
+      continue;
+    }
+    int node = 0;
+    for(int k = 0; k < f.len; k++) {
+      int c = trie[node].child;
+      while(c && trie[c].c != f.str[k]) {
+        c = trie[c].next;
+      }
+      if(!c) {
+        c = n++;
+        trie[c] = (EXT_ARGS_TrieNode){.c = f.str[k], .next = trie[node].child, .floatIdx = i};
+        trie[node].child = c;
+      } else if(trie[c].floatIdx >= 0 && floats[trie[c].floatIdx].groupIdx != f.groupIdx) {
+        trie[c].floatIdx = EXT_ARGS_TRIE_AMBIGUOUS;
+      }
+      node = c;
+    }
+  }
+  return trie;
+}
+
+// Index in `floats` of the long alias `str` abbreviates, -1 when there is
+// none or EXT_ARGS_TRIE_AMBIGUOUS. Costs O(len)
+static int EXT_ARGS_FindAbbrev(const ext_args_schema *schema, const char *str, int len) {
+  if(!schema->trie || len <= 2 || str[0] != '-' || str[1] != '-') {
+    return -1;
+  }
+  int node = 0;
+  for(int k = 0; k < len; k++) {
+    int c = schema->trie[node].child;
+    while(c && schema->trie[c].c != str[k]) {
+      c = schema->trie[c].next;
+    }
+    if(!c) {
+      return -1;
+    }
+    node = c;
+  }
+  return schema->trie[node].floatIdx;
+}
+
+static int *EXT_ARGS_BuildShortIndex(const ext_args_allocator *mem, const EXT_ARGS_FloatArg *floats, int count) {
+  int *index = EXT_ARGS_Alloc(mem, sizeof(*index) * 256);
+  if(!index) {
+    return NULL;
+  }
+  for(int c = 0; c < 256; c++) {
+    index[c] = -1;
+  }
+  for(int i = 0; i < count; i++) {
+    if(floats[i].len == 2 && floats[i].str[0] == '-' && floats[i].str[1] != '-') {
+      index[(unsigned char)floats[i].str[1]] = i;
+    }
+  }
+  return index;
+}
+
+// Number of the single letter aliases clustered in `str`, 3 for "-xvf". 0
+// when it's not a cluster: an alias itself or a letter isn't one
+static int EXT_ARGS_ClusterLen(const ext_args_schema *schema, const char *str, int len) {
+  if(!schema->shortIndex || len < 3 || str[0] != '-' || str[1] == '-' || EXT_ARGS_FindFloat(schema, str, len) != -1) {
+    return 0;
+  }
+  for(int k = 1; k < len; k++) {
+    if(schema->shortIndex[(unsigned char)str[k]] == -1) {
+      return 0;
+    }
+  }
+  return len - 1;
+}
+
+static bool EXT_ARGS_IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Reads decimal digits from [*ps, end), at least one is required
+static int EXT_ARGS_ConvDigits(const char **ps, const char *end, unsigned long long *out) {
+  const char *s = *ps;
+  unsigned long long v = 0;
+  int res = EXT_ARGS_CONV_OK;
+
+  if(s == end || !EXT_ARGS_IsDigit(*s)) {
+    return EXT_ARGS_CONV_INVALID;
+  }
+  for(; s < end && EXT_ARGS_IsDigit(*s); s++) {
+    unsigned d = *s - '0';
+    if(v > (ULLONG_MAX - d) / 10) {
+      res = EXT_ARGS_CONV_RANGE; // keep going, an invalid tail wins over the range error
+    }
+    v = v * 10 + d;
+  }
+
+  *ps = s;
+  *out = v;
+  return res;
+}
+
+static int EXT_ARGS_ConvInt(const char *s, const char *end, long long *out) {
+  bool neg = false;
+  if(s < end && (*s == '-' || *s == '+')) {
+    neg = *s == '-';
+    s++;
+  }
+
+  unsigned long long v;
+  int res = EXT_ARGS_ConvDigits(&s, end, &v);
+  if(s != end) {
+    return EXT_ARGS_CONV_INVALID;
+  }
+  if(res != EXT_ARGS_CONV_OK) {
+    return res;
+  }
+
+  if(neg) {
+    if(v > (unsigned long long)LLONG_MAX + 1) {
+      return EXT_ARGS_CONV_RANGE;
+    }
+    *out = v == (unsigned long long)LLONG_MAX + 1 ? LLONG_MIN : -(long long)v;
+  } else {
+    if(v > LLONG_MAX) {
+      return EXT_ARGS_CONV_RANGE;
+    }
+    *out = (long long)v;
+  }
+  return EXT_ARGS_CONV_OK;
+}
+
+static int EXT_ARGS_ConvUInt(const char *s, const char *end, unsigned long long *out) {
+  if(s < end && *s == '+') {
+    s++;
+  }
+
+  int res = EXT_ARGS_ConvDigits(&s, end, out);
+  if(s != end) {
+    return EXT_ARGS_CONV_INVALID;
+  }
+  return res;
+}
+
+// Numbers with up to 19 significant digits and a small exponent are exact
+// as a single multiplication or division, everything else goes to strtod
+static int EXT_ARGS_ConvF64(const char *str, const char *end, double *out) {
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char *s = str;
+  bool neg = false;
+  if(s < end && (*s == '-' || *s == '+')) {
+    neg = *s == '-';
+    s++;
+  }
+
+  unsigned long long m = 0;
+  int digits = 0, exp = 0;
+  bool hasDigits = false;
+  for(; s < end && EXT_ARGS_IsDigit(*s); s++) {
+    hasDigits = true;
+    if(digits || *s != '0') {
+      if(digits < 19) {
+        m = m * 10 + (*s - '0');
+      } else {
+        exp++;
+      }
+      digits++;
+    }
+  }
+  if(s < end && *s == '.') {
+    for(s++; s < end && EXT_ARGS_IsDigit(*s); s++) {
+      hasDigits = true;
+      if(digits || *s != '0') {
+        if(digits < 19) {
+          m = m * 10 + (*s - '0');
+          exp--;
+        }
+        digits++;
+      } else {
+        exp--;
+      }
+    }
+  }
+  if(hasDigits && s < end && (*s == 'e' || *s == 'E')) {
+    const char *e = s + 1;
+    bool eneg = false;
+    if(e < end && (*e == '-' || *e == '+')) {
+      eneg = *e == '-';
+      e++;
+    }
+    int ev = 0;
+    if(e < end && EXT_ARGS_IsDigit(*e)) {
+      for(; e < end && EXT_ARGS_IsDigit(*e); e++) {
+        if(ev < 100000) {
+          ev = ev * 10 + (*e - '0');
+        }
+      }
+      exp += eneg ? -ev : ev;
+      s = e;
+    }
+  }
+
+  if(hasDigits && s == end && digits <= 19 && m <= (1ULL << 53) && exp >= -22 && exp <= 22) {
+    double d = (double)m;
+    d = exp < 0 ? d / pow10[-exp] : d * pow10[exp];
+    *out = neg ? -d : d;
+    return EXT_ARGS_CONV_OK;
+  }
+
+  // Slow path. strtod follows the locale decimal point, so it's swapped in
+  char buf[128];
+  size_t len = (size_t)(end - str);
+  if(len >= sizeof(buf) || (len && (str[0] == ' ' || (str[0] >= '\t' && str[0] <= '\r')))) {
+    return EXT_ARGS_CONV_INVALID;
+  }
+  char dp = localeconv()->decimal_point[0];
+  for(size_t i = 0; i < len; i++) {
+    buf[i] = str[i] == '.' ? dp : str[i];
+  }
+  buf[len] = '\0';
+
+  char *e;
+  errno = 0;
+  double d = strtod(buf, &e);
+  if(!len || e != buf + len) {
+    return EXT_ARGS_CONV_INVALID;
+  }
+  if(errno == ERANGE && (d == HUGE_VAL || d == -HUGE_VAL)) {
+    return EXT_ARGS_CONV_RANGE;
+  }
+  *out = d;
+  return EXT_ARGS_CONV_OK;
+}
+
+// 64K, 2M, 1G, 1T, "B" and "iB" may follow: 64KB, 64KiB
+static int EXT_ARGS_ConvSize(const char *s, const char *end, size_t *out) {
+  unsigned long long v;
+  int res = EXT_ARGS_ConvDigits(&s, end, &v);
+  if(res == EXT_ARGS_CONV_INVALID) {
+    return res;
+  }
+
+  int shift = 0;
+  if(s < end) {
+    switch(*s) {
+      case 'k': case 'K': shift = 10; break;
+      case 'm': case 'M': shift = 20; break;
+      case 'g': case 'G': shift = 30; break;
+      case 't': case 'T': shift = 40; break;
+      case 'b': case 'B': break;
+      default: return EXT_ARGS_CONV_INVALID;
+    }
+    if(shift) {
+      s++;
+      if(s < end && *s == 'i') {
+        s++;
+        if(s == end) {
+          return EXT_ARGS_CONV_INVALID;
+        }
+      }
+    }
+    if(s < end && (*s == 'b' || *s == 'B')) {
+      s++;
+    }
+  }
+  if(s != end) {
+    return EXT_ARGS_CONV_INVALID;
+  }
+
+  if(res == EXT_ARGS_CONV_RANGE || v > ((unsigned long long)SIZE_MAX >> shift)) {
+    return EXT_ARGS_CONV_RANGE;
+  }
+  *out = (size_t)(v << shift);
+  return EXT_ARGS_CONV_OK;
+}
+
+// 1.5s, 250ms, 10us, 100ns, 5m, 2h, a bare number means seconds
+static int EXT_ARGS_ConvDuration(const char *s, const char *end, double *out) {
+  static const struct {
+    const char *name;
+    double mul;
+  } units[] = {{"ns", 1e-9}, {"us", 1e-6}, {"ms", 1e-3}, {"s", 1}, {"m", 60}, {"h", 3600}};
+
+  const char *u = end;
+  while(u > s && ((u[-1] >= 'a' && u[-1] <= 'z') || (u[-1] >= 'A' && u[-1] <= 'Z'))) {
+    u--;
+  }
+
+  double mul = 1;
+  if(u != end) {
+    int i = 0, n = (int)(sizeof(units) / sizeof(*units));
+    for(; i < n; i++) {
+      if((int)strlen(units[i].name) == end - u && strncmp(units[i].name, u, end - u) == 0) {
+        break;
+      }
+    }
+    if(i == n) {
+      return EXT_ARGS_CONV_INVALID;
+    }
+    mul = units[i].mul;
+  }
+
+  double d;
+  int res = EXT_ARGS_ConvF64(s, u, &d);
+  if(res != EXT_ARGS_CONV_OK) {
+    return res;
+  }
+  if(d < 0 || d != d) {
+    return EXT_ARGS_CONV_RANGE;
+  }
+  *out = d * mul;
+  return EXT_ARGS_CONV_OK;
+}
+
+static int EXT_ARGS_ConvBool(const char *s, const char *end, bool *out) {
+  static const struct {
+    const char *name;
+    bool val;
+  } names[] = {
+    {"true", true}, {"yes", true}, {"on", true}, {"1", true},
+    {"false", false}, {"no", false}, {"off", false}, {"0", false}
+  };
+
+  for(int i = 0; i < (int)(sizeof(names) / sizeof(*names)); i++) {
+    const char *n = names[i].name, *p = s;
+    for(; p < end && *n && (*p | 0x20) == *n; p++, n++) {}
+    if(p == end && !*n) {
+      *out = names[i].val;
+      return EXT_ARGS_CONV_OK;
+    }
+  }
+  return EXT_ARGS_CONV_INVALID;
+}
+
+static int EXT_ARGS_Convert(int type, const char *str, EXT_ARGS_Value *out) {
+  const char *end = str + strlen(str);
+  switch(type) {
+    case EXT_ARGS_T_INT: return EXT_ARGS_ConvInt(str, end, &out->i);
+    case EXT_ARGS_T_UINT: return EXT_ARGS_ConvUInt(str, end, &out->u);
+    case EXT_ARGS_T_F64: return EXT_ARGS_ConvF64(str, end, &out->d);
+    case EXT_ARGS_T_SIZE: return EXT_ARGS_ConvSize(str, end, &out->z);
+    case EXT_ARGS_T_DURATION: return EXT_ARGS_ConvDuration(str, end, &out->d);
+    case EXT_ARGS_T_BOOL: return EXT_ARGS_ConvBool(str, end, &out->b);
+  }
+  return EXT_ARGS_CONV_OK;
+}
+
+// Writes a converted value into the variable of the type's receiver type
+static void EXT_ARGS_StoreValue(int type, void *varPtr, EXT_ARGS_Value val) {
+  switch(type) {
+    case EXT_ARGS_T_INT: *((long long *)varPtr) = val.i; break;
+    case EXT_ARGS_T_UINT: *((unsigned long long *)varPtr) = val.u; break;
+    case EXT_ARGS_T_F64:
+    case EXT_ARGS_T_DURATION: *((double *)varPtr) = val.d; break;
+    case EXT_ARGS_T_SIZE: *((size_t *)varPtr) = val.z; break;
+    case EXT_ARGS_T_BOOL: *((bool *)varPtr) = val.b; break;
+  }
+}
+
+// Matches `prefix` followed by `str`, like "--" and a config file key,
+// without building the joined string. Returns index in `floats` or -1
+static int EXT_ARGS_FindFloatPrefixed(const ext_args_schema *schema, const char *prefix, const char *str, int len) {
+  int plen = strlen(prefix);
+  if(!schema->aliasIndex) {
+    for(int i = 0; i < schema->floatsCount; i++) {
+      EXT_ARGS_FloatArg f = schema->floats[i];
+      if(f.len == plen + len && strncmp(f.str, prefix, plen) == 0 && strncmp(f.str + plen, str, len) == 0) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  unsigned slot = EXT_ARGS_HashMore(EXT_ARGS_Hash(prefix, plen), str, len) & schema->aliasIndexMask;
+  for(;;) {
+    int fi = schema->aliasIndex[slot];
+    if(fi == -1) {
+      return -1;
+    }
+    EXT_ARGS_FloatArg f = schema->floats[fi];
+    if(f.len == plen + len && strncmp(f.str, prefix, plen) == 0 && strncmp(f.str + plen, str, len) == 0) {
+      return fi;
+    }
+    slot = (slot + 1) & schema->aliasIndexMask;
+  }
+}
+
+static char *EXT_ARGS_FmtErr(const ext_args_allocator *mem, jmp_buf jbuf, char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int len = vsnprintf(&(char){0}, 1, fmt, ap);
+  va_end(ap);
+
+  char *str = EXT_ARGS_Alloc(mem, len + 1);
+  if (!str) {
+    longjmp(jbuf, EXT_ARGS_ERR_MEM); \
+  }
+
+  va_start(ap, fmt);
+  vsnprintf(str, len + 1, fmt, ap);
+  va_end(ap);
+  return str;
+}
+
+static void EXT_ARGS_ReleaseMapping(const ext_args_allocator *mem, EXT_ARGS_Mapping m) {
+#ifndef EXT_ARGS_NO_MMAP
+  if(m.isMapped) {
+    munmap(m.addr, m.size);
+    return;
+  }
+#endif
+  EXT_ARGS_Free(mem, m.addr);
+}
+
+EXT_ARGS_API void ext_args_schema_free(ext_args_schema *schema) {
+  if(!schema) {
+    return;
+  }
+  const ext_args_allocator *mem = schema->mem;
+  EXT_ARGS_Free(mem, (void *)schema->posArgs);
+  EXT_ARGS_Free(mem, (void *)schema->groups);
+  EXT_ARGS_Free(mem, (void *)schema->floats);
+  EXT_ARGS_Free(mem, (void *)schema->trie);
+  EXT_ARGS_Free(mem, (void *)schema->shortIndex);
+  if(schema->map.addr) {
+    EXT_ARGS_ReleaseMapping(mem, schema->map);
+  } else {
+    EXT_ARGS_Free(mem, (void *)schema->sequence);
+    EXT_ARGS_Free(mem, (void *)schema->aliasIndex);
+    EXT_ARGS_Free(mem, schema->fmt);
+  }
+  EXT_ARGS_Free(mem, schema);
+}
+
+static void EXT_ARGS_ParserUseInline(EXT_ARGS_Parser *prs, EXT_ARGS_ParserInline *storage) {
+  EXT_ARGS_DYN_ARY_USE_INLINE(prs, posArgs, storage->posArgs);
+  EXT_ARGS_DYN_ARY_USE_INLINE(prs, groups, storage->groups);
+  EXT_ARGS_DYN_ARY_USE_INLINE(prs, floats, storage->floats);
+  EXT_ARGS_DYN_ARY_USE_INLINE(prs, sequence, storage->sequence);
+}
+
+static void EXT_ARGS_ParserFree(EXT_ARGS_Parser *prs) {
+  EXT_ARGS_DYN_ARY_FREE(prs, posArgs, prs->mem);
+  EXT_ARGS_DYN_ARY_FREE(prs, groups, prs->mem);
+  EXT_ARGS_DYN_ARY_FREE(prs, floats, prs->mem);
+  EXT_ARGS_DYN_ARY_FREE(prs, sequence, prs->mem);
+}
+
+// Runs the grammar over `prs->str`. On success `schema` gets the structure,
+// the arrays still belong to `prs`
+static int EXT_ARGS_Compile(EXT_ARGS_Parser *prs, ext_args_schema *schema, char **oerr) {
+  int res = EXT_ARGS_NO_ERR;
+#ifdef EXT_ARGS_STATS
+  uint64_t start = EXT_ARGS_Now();
+#endif
+
+  int jval = setjmp(prs->jbuf);
+  switch(jval) {
+    case 0:
+      EXT_ARGS_Synopsis(prs);
+#ifdef EXT_ARGS_STATS
+      EXT_ARGS_StatsAdd(&EXT_ARGS_Totals, &(ext_args_stats){
+        .compiles = 1,
+        .ticks[EXT_ARGS_PHASE_SYNOPSIS] = EXT_ARGS_Now() - start
+      }, true);
+#endif
+      break;
+
+    case EXT_ARGS_ERR_LEX:
+      res = EXT_ARGS_SCHEMA_ERR;
+      *oerr = EXT_ARGS_FmtErr(prs->mem, prs->jbuf, "Schema lexing error, starting from \"%s\"", prs->errStart);
+      return res;
+
+    case EXT_ARGS_ERR_PARSE:
+      res = EXT_ARGS_SCHEMA_ERR;
+      *oerr = EXT_ARGS_FmtErr(prs->mem, prs->jbuf, "Schema parsing error. Expected %s but received %s, starting from \"%s\"",
+          EXT_ARGS_TokTypeToName(prs->expTokType), EXT_ARGS_TokTypeToName(prs->unexpTokType), prs->errStart);
+      return res;
+
+    case EXT_ARGS_ERR_TYPE:
+      res = EXT_ARGS_SCHEMA_ERR;
+      *oerr = EXT_ARGS_FmtErr(prs->mem, prs->jbuf, "Schema parsing error. Unknown value type, starting from \"%s\"", prs->errStart);
+      return res;
+
+    case EXT_ARGS_ERR_MEM:
+      *oerr = NULL;
+      return EXT_ARGS_NO_MEM_ERR;
+  }
+
+  // Additional schema validations
+  if(prs->posArgsCount > 1) {
+    for(int i = 0; i < prs->posArgsCount - 1; i++) {
+      // Schema like this is not allowed: "[a] b". This is ok: "a [b]"
+      if(prs->posArgs[i].isOptional && !prs->posArgs[i + 1].isOptional) {
+        res = EXT_ARGS_SCHEMA_ERR;
+        *oerr = EXT_ARGS_FmtErr(prs->mem, prs->jbuf, "All optional non-flag arguments must be chained on the schema's right side");
+        return res;
+      }
+    }
+  }
+
+  for(int i = 0; i < prs->floatsCount; i++) {
+    EXT_ARGS_FloatArgsGroup gr = prs->groups[prs->floats[i].groupIdx];
+    if(gr.isRepeating && gr.valType != EXT_ARGS_T_STR) {
+      res = EXT_ARGS_SCHEMA_ERR;
+      *oerr = EXT_ARGS_FmtErr(prs->mem, prs->jbuf, "Repeating argument \"%.*s\" can't have a typed value",
+          prs->floats[i].len, prs->floats[i].str);
+      return res;
+    }
+  }
+
+  schema->posArgs = prs->posArgs;
+  schema->posArgsCount = prs->posArgsCount;
+  schema->groups = prs->groups;
+  schema->groupsCount = prs->groupsCount;
+  schema->floats = prs->floats;
+  schema->floatsCount = prs->floatsCount;
+  schema->sequence = prs->sequence;
+  schema->sequenceCount = prs->sequenceCount;
+  schema->varPosArgsEnabled = prs->varPosArgsEnabled;
+
+  return res;
+}
+
+EXT_ARGS_API int ext_args_compile_ex(char *fmt, const ext_args_allocator *allocator,
+    ext_args_schema **oschema, char **oerr) {
+  *oschema = NULL;
+  *oerr = NULL;
+
+  ext_args_schema *schema = EXT_ARGS_Calloc(allocator, 1, sizeof(*schema));
+  if(!schema) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  if(allocator) {
+    schema->allocator = *allocator;
+    schema->mem = &schema->allocator;
+  }
+
+  size_t fmtLen = strlen(fmt);
+  schema->fmt = EXT_ARGS_Alloc(schema->mem, fmtLen + 1);
+  if(!schema->fmt) {
+    EXT_ARGS_Free(allocator, schema);
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  memcpy(schema->fmt, fmt, fmtLen + 1);
+
+  EXT_ARGS_ParserInline storage;
+  EXT_ARGS_Parser *prs = &(EXT_ARGS_Parser){.str = schema->fmt, .mem = schema->mem};
+  EXT_ARGS_ParserUseInline(prs, &storage);
+
+  int res = EXT_ARGS_Compile(prs, schema, oerr);
+  if(res == EXT_ARGS_NO_ERR) {
+    // The structure is moved out of the parser into exactly sized blocks
+    schema->posArgs = EXT_ARGS_Dup(schema->mem, prs->posArgs, prs->posArgsCount, sizeof(*prs->posArgs));
+    schema->groups = EXT_ARGS_Dup(schema->mem, prs->groups, prs->groupsCount, sizeof(*prs->groups));
+    schema->floats = EXT_ARGS_Dup(schema->mem, prs->floats, prs->floatsCount, sizeof(*prs->floats));
+    schema->sequence = EXT_ARGS_Dup(schema->mem, prs->sequence, prs->sequenceCount, sizeof(*prs->sequence));
+    schema->aliasIndex = EXT_ARGS_BuildAliasIndex(schema->mem, prs->floats, prs->floatsCount, &schema->aliasIndexMask);
+    schema->trie = EXT_ARGS_BuildTrie(schema->mem, prs->floats, prs->floatsCount);
+    schema->shortIndex = EXT_ARGS_BuildShortIndex(schema->mem, prs->floats, prs->floatsCount);
+
+    if((!schema->posArgs && prs->posArgsCount) || (!schema->groups && prs->groupsCount) ||
+        (!schema->floats && prs->floatsCount) || (!schema->sequence && prs->sequenceCount) || !schema->aliasIndex ||
+        !schema->trie || !schema->shortIndex) {
+      res = EXT_ARGS_NO_MEM_ERR;
+    }
+  } else {
+    *schema = (ext_args_schema){.mem = schema->mem, .allocator = schema->allocator, .fmt = schema->fmt};
+  }
+
+  EXT_ARGS_ParserFree(prs);
+
+  if(res != EXT_ARGS_NO_ERR) {
+    ext_args_schema_free(schema);
+    return res;
+  }
+
+  *oschema = schema;
+  return res;
+}
+
+EXT_ARGS_API int ext_args_compile(char *fmt, ext_args_schema **oschema, char **oerr) {
+  return ext_args_compile_ex(fmt, NULL, oschema, oerr);
+}
+
+// Receiver variable size of a floating arguments group
+static size_t EXT_ARGS_GroupVarSize(const EXT_ARGS_FloatArgsGroup *gr) {
+  if(gr->isRepeating) {
+    return sizeof(char **);
+  }
+  if(!gr->hasAssign) {
+    return sizeof(bool);
+  }
+  switch(gr->valType) {
+    case EXT_ARGS_T_INT: return sizeof(long long);
+    case EXT_ARGS_T_UINT: return sizeof(unsigned long long);
+    case EXT_ARGS_T_F64:
+    case EXT_ARGS_T_DURATION: return sizeof(double);
+    case EXT_ARGS_T_SIZE: return sizeof(size_t);
+    case EXT_ARGS_T_BOOL: return sizeof(bool);
+  }
+  return sizeof(char *);
+}
+
+// Field type receiving the values of a floating arguments group
+static int EXT_ARGS_GroupFieldType(const EXT_ARGS_FloatArgsGroup *gr) {
+  if(gr->isRepeating) {
+    return EXT_ARGS_FIELD_LIST;
+  }
+  if(!gr->hasAssign) {
+    return EXT_ARGS_FIELD_BOOL;
+  }
+  switch(gr->valType) {
+    case EXT_ARGS_T_INT: return EXT_ARGS_FIELD_INT;
+    case EXT_ARGS_T_UINT: return EXT_ARGS_FIELD_UINT;
+    case EXT_ARGS_T_F64:
+    case EXT_ARGS_T_DURATION: return EXT_ARGS_FIELD_F64;
+    case EXT_ARGS_T_SIZE: return EXT_ARGS_FIELD_SIZE;
+    case EXT_ARGS_T_BOOL: return EXT_ARGS_FIELD_BOOL;
+  }
+  return EXT_ARGS_FIELD_STR;
+}
+
+static const char *EXT_ARGS_FieldTypeName(int type) {
+  static const char *names[] = {
+    [EXT_ARGS_FIELD_STR] = "char *",
+    [EXT_ARGS_FIELD_LIST] = "char **",
+    [EXT_ARGS_FIELD_BOOL] = "bool",
+    [EXT_ARGS_FIELD_INT] = "long long",
+    [EXT_ARGS_FIELD_UINT] = "unsigned long long",
+    [EXT_ARGS_FIELD_F64] = "double",
+    [EXT_ARGS_FIELD_SIZE] = "size_t"
+  };
+  return type > EXT_ARGS_FIELD_ANY && type <= EXT_ARGS_FIELD_SIZE ? names[type] : "unknown";
+}
+
+EXT_ARGS_API void ext_args_bound_free(ext_args_bound *bound) {
+  if(!bound) {
+    return;
+  }
+  EXT_ARGS_Free(bound->schema->mem, (void *)bound->offsets);
+  EXT_ARGS_Free(bound->schema->mem, bound);
+}
+
+EXT_ARGS_API int ext_args_bind(const ext_args_schema *schema, const ext_args_binding *table,
+    ext_args_bound **obound, char **oerr) {
+  const ext_args_allocator *mem = schema->mem;
+  *oerr = NULL;
+
+  // Allocated before setjmp, so the handler sees it
+  ext_args_bound *bound = EXT_ARGS_Calloc(mem, 1, sizeof(*bound));
+  if(!bound) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  bound->schema = schema;
+
+  int count = schema->groupsCount + schema->posArgsCount + 1;
+  size_t *offsets = EXT_ARGS_Alloc(mem, count * sizeof(*offsets));
+  if(!offsets) {
+    ext_args_bound_free(bound);
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  bound->offsets = offsets;
+
+  jmp_buf jbuf;
+  if(setjmp(jbuf) == EXT_ARGS_ERR_MEM) {
+    ext_args_bound_free(bound);
+    *oerr = NULL;
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+
+  int res = EXT_ARGS_NO_ERR;
+  for(int i = 0; i < count; i++) {
+    offsets[i] = EXT_ARGS_UNBOUND;
+  }
+
+  for(const ext_args_binding *b = table; b->name; b++) {
+    int len = strlen(b->name);
+    int slot = -1;
+    size_t size = sizeof(char *);
+    int type = EXT_ARGS_FIELD_STR;
+
+    int fi = EXT_ARGS_FindFloat(schema, b->name, len);
+    if(fi != -1) {
+      slot = schema->floats[fi].groupIdx;
+      size = EXT_ARGS_GroupVarSize(&schema->groups[slot]);
+      type = EXT_ARGS_GroupFieldType(&schema->groups[slot]);
+    } else if(schema->varPosArgsEnabled && strcmp(b->name, "...") == 0) {
+      slot = count - 1;
+      size = sizeof(char **);
+      type = EXT_ARGS_FIELD_LIST;
+    } else {
+      for(int i = 0; i < schema->posArgsCount; i++) {
+        EXT_ARGS_PosArg pa = schema->posArgs[i];
+        if(pa.len == len && strncmp(pa.str, b->name, len) == 0) {
+          slot = schema->groupsCount + i;
+          break;
+        }
+      }
+    }
+
+    if(slot == -1) {
+      res = EXT_ARGS_SCHEMA_ERR;
+      *oerr = EXT_ARGS_FmtErr(mem, jbuf, "Unknown binding \"%s\"", b->name);
+      break;
+    }
+    if(b->size != size) {
+      res = EXT_ARGS_SCHEMA_ERR;
+      *oerr = EXT_ARGS_FmtErr(mem, jbuf, "Binding \"%s\" field size is %u, expected %u",
+          b->name, (unsigned)b->size, (unsigned)size);
+      break;
+    }
+    if(b->type != EXT_ARGS_FIELD_ANY && b->type != type) {
+      res = EXT_ARGS_SCHEMA_ERR;
+      *oerr = EXT_ARGS_FmtErr(mem, jbuf, "Binding \"%s\" field type is %s, expected %s",
+          b->name, EXT_ARGS_FieldTypeName(b->type), EXT_ARGS_FieldTypeName(type));
+      break;
+    }
+    if(offsets[slot] != EXT_ARGS_UNBOUND) {
+      res = EXT_ARGS_SCHEMA_ERR;
+      *oerr = EXT_ARGS_FmtErr(mem, jbuf, "Argument \"%s\" is bound more than once", b->name);
+      break;
+    }
+    offsets[slot] = b->offset;
+  }
+
+  if(res != EXT_ARGS_NO_ERR) {
+    ext_args_bound_free(bound);
+    return res;
+  }
+
+  *obound = bound;
+  return res;
+}
+
+// Source of EXT_ARGS_ReadAll: the already open descriptor with mmap, stdio
+// without it
+#ifndef EXT_ARGS_NO_MMAP
+typedef int EXT_ARGS_Src;
+
+// Bytes read, 0 at the end, -1 on error
+static long EXT_ARGS_SrcRead(EXT_ARGS_Src fd, char *buf, size_t size) {
+  ssize_t n;
+  do {
+    n = read(fd, buf, size);
+  } while(n == -1 && errno == EINTR);
+  return n;
+}
+
+static void EXT_ARGS_SrcClose(EXT_ARGS_Src fd) {
+  close(fd);
+}
+#else
+typedef FILE *EXT_ARGS_Src;
+
+static long EXT_ARGS_SrcRead(EXT_ARGS_Src f, char *buf, size_t size) {
+  size_t n = fread(buf, 1, size, f);
+  return n == 0 && ferror(f) ? -1 : (long)n;
+}
+
+static void EXT_ARGS_SrcClose(EXT_ARGS_Src f) {
+  fclose(f);
+}
+#endif
+
+// Reads the rest of `src` into a buffer with a zero byte after its end, then
+// closes it. Pipes may return less than asked, so it reads until the end
+static bool EXT_ARGS_ReadAll(const ext_args_allocator *mem, jmp_buf jbuf, EXT_ARGS_Src src, EXT_ARGS_Mapping *m) {
+  size_t size = 0, allocated = 4096;
+  char *buf = EXT_ARGS_Alloc(mem, allocated);
+  long n;
+  for(;;) {
+    if(!buf) {
+      EXT_ARGS_SrcClose(src);
+      longjmp(jbuf, EXT_ARGS_ERR_MEM);
+    }
+    n = EXT_ARGS_SrcRead(src, buf + size, allocated - size - 1);
+    if(n <= 0) {
+      break;
+    }
+    size += n;
+    if(size < allocated - 1) {
+      continue;
+    }
+    char *p = EXT_ARGS_Realloc(mem, buf, allocated, allocated * 2);
+    if(!p) {
+      EXT_ARGS_Free(mem, buf);
+    }
+    buf = p;
+    allocated *= 2;
+  }
+  EXT_ARGS_SrcClose(src);
+  if(n == -1) {
+    EXT_ARGS_Free(mem, buf);
+    return false;
+  }
+  buf[size] = '\0';
+
+  *m = (EXT_ARGS_Mapping){.addr = buf, .size = allocated, .isMapped = false};
+  return true;
+}
+
+// Reads a whole file with a zero byte after its end. A regular file is
+// mapped privately, so tokenizing in place doesn't change it and only the
+// touched pages get copied. Pipes and devices like `/dev/stdin` are read
+// from the same descriptor. Returns false when the file can't be read
+static bool EXT_ARGS_ReadFile(const ext_args_allocator *mem, jmp_buf jbuf, const char *path, EXT_ARGS_Mapping *m) {
+#ifndef EXT_ARGS_NO_MMAP
+  int fd = open(path, O_RDONLY);
+  if(fd == -1) {
+    return false;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) == -1) {
+    close(fd);
+    return false;
+  }
+  if(!S_ISREG(st.st_mode)) {
+    return EXT_ARGS_ReadAll(mem, jbuf, fd, m);
+  }
+
+  // The region is reserved one byte longer than the file with zero pages,
+  // then the file is mapped over its beginning. When the file size is a
+  // multiple of the page size the zero byte comes from the reserved page
+  size_t size = st.st_size;
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t len = (size + page) / page * page;
+
+  int zfd = open("/dev/zero", O_RDONLY);
+  if(zfd == -1) {
+    close(fd);
+    return false;
+  }
+  char *addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, zfd, 0);
+  close(zfd);
+  if(addr == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  if(size && mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(addr, len);
+    close(fd);
+    return false;
+  }
+  close(fd);
+
+  *m = (EXT_ARGS_Mapping){.addr = addr, .size = len, .isMapped = true};
+  return true;
+#else
+  FILE *f = fopen(path, "rb");
+  if(!f) {
+    return false;
+  }
+  return EXT_ARGS_ReadAll(mem, jbuf, f, m);
+#endif
+}
+
+static bool EXT_ARGS_IsSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+EXT_ARGS_API void ext_args_response_files_release(ext_args_response_files *rf) {
+  for(int i = 0; i < rf->mapsCount; i++) {
+    EXT_ARGS_ReleaseMapping(rf->mem, rf->maps[i]);
+  }
+  EXT_ARGS_Free(rf->mem, rf->maps);
+  *rf = (ext_args_response_files){.maxDepth = rf->maxDepth};
+}
+
+EXT_ARGS_API void ext_args_config_free(ext_args_config *cfg) {
+  if(!cfg) {
+    return;
+  }
+  const ext_args_allocator *mem = cfg->mem;
+  EXT_ARGS_ReleaseMapping(mem, cfg->map);
+  EXT_ARGS_Free(mem, cfg->entries);
+  EXT_ARGS_Free(mem, cfg);
+}
+
+// Trims whitespace around [*start, end), returns the new length
+static int EXT_ARGS_Trim(char **start, char *end) {
+  while(*start < end && EXT_ARGS_IsSpace(**start)) {
+    (*start)++;
+  }
+  while(end > *start && EXT_ARGS_IsSpace(end[-1])) {
+    end--;
+  }
+  return end - *start;
+}
+
+EXT_ARGS_API int ext_args_config_load(const char *path, const ext_args_allocator *allocator,
+    ext_args_config **ocfg, char **oerr) {
+  *oerr = NULL;
+
+  // Allocated before setjmp, so the handler sees it
+  ext_args_config *cfg = EXT_ARGS_Calloc(allocator, 1, sizeof(*cfg));
+  if(!cfg) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  if(allocator) {
+    cfg->allocator = *allocator;
+    cfg->mem = &cfg->allocator;
+  }
+
+  jmp_buf jbuf;
+  if(setjmp(jbuf) == EXT_ARGS_ERR_MEM) {
+    ext_args_config_free(cfg);
+    *oerr = NULL;
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+
+  int res = EXT_ARGS_NO_ERR;
+  if(!EXT_ARGS_ReadFile(cfg->mem, jbuf, path, &cfg->map)) {
+    *oerr = EXT_ARGS_FmtErr(cfg->mem, jbuf, "Can't read config file \"%s\"", path);
+    ext_args_config_free(cfg);
+    return EXT_ARGS_INPUT_ERR;
+  }
+
+  char *line = cfg->map.addr;
+  for(int lineNo = 1; *line; lineNo++) {
+    char *end = strchr(line, '\n');
+    char *next = end ? end + 1 : line + strlen(line);
+    if(!end) {
+      end = next;
+    }
+
+    char *key = line;
+    char *eq = memchr(line, '=', end - line);
+    int keyLen = EXT_ARGS_Trim(&key, eq ? eq : end);
+    if(keyLen == 0 || *key == '#' || *key == ';') {
+      if(keyLen == 0 && eq) {
+        res = EXT_ARGS_INPUT_ERR;
+        *oerr = EXT_ARGS_FmtErr(cfg->mem, jbuf, "Config file \"%s\" line %d has no key", path, lineNo);
+        break;
+      }
+      line = next;
+      continue;
+    }
+
+    char *val = NULL;
+    if(eq) {
+      val = eq + 1;
+      int valLen = EXT_ARGS_Trim(&val, end);
+      if(valLen >= 2 && val[0] == '"' && val[valLen - 1] == '"') {
+        val++;
+        valLen -= 2;
+      }
+      val[valLen] = '\0';
+    }
+    key[keyLen] = '\0';
+
+    EXT_ARGS_DYN_ARY_SAVE(cfg, entries, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_ConfigEntry){
+      .key = key, .keyLen = keyLen, .val = val}), cfg->mem, jbuf);
+    line = next;
+  }
+
+  if(res != EXT_ARGS_NO_ERR) {
+    ext_args_config_free(cfg);
+    return res;
+  }
+
+  *ocfg = cfg;
+  return res;
+}
+
+EXT_ARGS_API int ext_args_schema_save(const ext_args_schema *schema, const char *path, char **oerr) {
+  const ext_args_allocator *mem = schema->mem;
+  jmp_buf jbuf;
+  *oerr = NULL;
+
+  if(setjmp(jbuf) == EXT_ARGS_ERR_MEM) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+
+  if(!schema->fmt || !schema->aliasIndex) {
+    *oerr = EXT_ARGS_FmtErr(mem, jbuf, "Only compiled schemas can be saved");
+    return EXT_ARGS_INPUT_ERR;
+  }
+
+  size_t fmtLen = strlen(schema->fmt);
+  EXT_ARGS_ImageHeader h = {
+    .magic = EXT_ARGS_IMAGE_MAGIC,
+    .version = EXT_ARGS_IMAGE_VERSION,
+    .posArgsCount = schema->posArgsCount,
+    .groupsCount = schema->groupsCount,
+    .floatsCount = schema->floatsCount,
+    .sequenceCount = schema->sequenceCount,
+    .varPosArgsEnabled = schema->varPosArgsEnabled,
+    .aliasIndexMask = schema->aliasIndexMask
+  };
+  size_t size = sizeof(h);
+  h.posArgs = size;
+  size += sizeof(EXT_ARGS_ImagePosArg) * schema->posArgsCount;
+  h.groups = size;
+  size += sizeof(EXT_ARGS_ImageGroup) * schema->groupsCount;
+  h.floats = size;
+  size += sizeof(EXT_ARGS_ImageFloat) * schema->floatsCount;
+  h.sequence = size;
+  size += sizeof(EXT_ARGS_SequenceElement) * schema->sequenceCount;
+  h.aliasIndex = size;
+  size += sizeof(int) * ((size_t)schema->aliasIndexMask + 1);
+  h.fmt = size;
+  size += fmtLen + 1;
+  h.size = size;
+  if(size > INT_MAX) {
+    *oerr = EXT_ARGS_FmtErr(mem, jbuf, "Schema is too big to be saved");
+    return EXT_ARGS_INPUT_ERR;
+  }
+
+  char *img = EXT_ARGS_Calloc(mem, 1, size);
+  if(!img) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  EXT_ARGS_ImagePosArg *posArgs = (EXT_ARGS_ImagePosArg *)(img + h.posArgs);
+  for(int i = 0; i < schema->posArgsCount; i++) {
+    const EXT_ARGS_PosArg *pa = &schema->posArgs[i];
+    posArgs[i] = (EXT_ARGS_ImagePosArg){pa->isOptional, pa->str - schema->fmt, pa->len};
+  }
+  EXT_ARGS_ImageGroup *groups = (EXT_ARGS_ImageGroup *)(img + h.groups);
+  for(int i = 0; i < schema->groupsCount; i++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[i];
+    groups[i] = (EXT_ARGS_ImageGroup){
+      .flags = (gr->isOptional ? EXT_ARGS_IMAGE_OPTIONAL : 0) | (gr->hasAssign ? EXT_ARGS_IMAGE_ASSIGN : 0) |
+               (gr->isAssignOptional ? EXT_ARGS_IMAGE_ASSIGN_OPTIONAL : 0) |
+               (gr->isRepeating ? EXT_ARGS_IMAGE_REPEATING : 0),
+      .aliasCount = gr->aliasCount,
+      .valType = gr->valType,
+      .seqIdx = gr->seqIdx,
+      .env = gr->envLen ? gr->env - schema->fmt : 0,
+      .envLen = gr->envLen
+    };
+  }
+  EXT_ARGS_ImageFloat *floats = (EXT_ARGS_ImageFloat *)(img + h.floats);
+  for(int i = 0; i < schema->floatsCount; i++) {
+    const EXT_ARGS_FloatArg *f = &schema->floats[i];
+    floats[i] = (EXT_ARGS_ImageFloat){f->str - schema->fmt, f->len, f->groupIdx};
+  }
+  memcpy(img + h.sequence, schema->sequence, sizeof(*schema->sequence) * schema->sequenceCount);
+  memcpy(img + h.aliasIndex, schema->aliasIndex, sizeof(int) * ((size_t)schema->aliasIndexMask + 1));
+  memcpy(img + h.fmt, schema->fmt, fmtLen + 1);
+  h.checksum = EXT_ARGS_HashMore(EXT_ARGS_HASH_INIT, img + sizeof(h), size - sizeof(h));
+  memcpy(img, &h, sizeof(h));
+
+  size_t pathLen = strlen(path);
+  char *tmp = EXT_ARGS_Alloc(mem, pathLen + sizeof(".tmp"));
+  if(!tmp) {
+    EXT_ARGS_Free(mem, img);
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  memcpy(tmp, path, pathLen);
+  memcpy(tmp + pathLen, ".tmp", sizeof(".tmp"));
+
+  FILE *f = fopen(tmp, "wb");
+  bool ok = f && fwrite(img, 1, size, f) == size;
+  ok = (f && fclose(f) == 0) && ok;
+  ok = ok && rename(tmp, path) == 0;
+  if(!ok) {
+    remove(tmp);
+  }
+  EXT_ARGS_Free(mem, tmp);
+  EXT_ARGS_Free(mem, img);
+
+  if(!ok) {
+    *oerr = EXT_ARGS_FmtErr(mem, jbuf, "Can't write schema file \"%s\"", path);
+    return EXT_ARGS_INPUT_ERR;
+  }
+  return EXT_ARGS_NO_ERR;
+}
+
+// Table of `count` rows of `rowSize` at `off` lies inside the image
+static bool EXT_ARGS_ImageHas(const EXT_ARGS_ImageHeader *h, uint32_t off, uint32_t count, size_t rowSize) {
+  return off >= sizeof(*h) && off % sizeof(uint32_t) == 0 && off <= h->size && (h->size - off) / rowSize >= count;
+}
+
+// Checks the image read into `schema->map` and points the schema into it.
+// False when it's stale, corrupt or of another version
+static bool EXT_ARGS_LoadImage(ext_args_schema *schema, const char *fmt, jmp_buf jbuf) {
+  const EXT_ARGS_ImageHeader *h = (const EXT_ARGS_ImageHeader *)schema->map.addr;
+  char *img = schema->map.addr;
+  size_t fmtLen = strlen(fmt);
+
+  if(schema->map.size < sizeof(*h) || h->magic != EXT_ARGS_IMAGE_MAGIC || h->version != EXT_ARGS_IMAGE_VERSION ||
+      h->size < sizeof(*h) || h->size > schema->map.size || h->size > INT_MAX) {
+    return false;
+  }
+  if(h->fmt < sizeof(*h) || h->fmt > h->size || h->size - h->fmt != fmtLen + 1 ||
+      memcmp(img + h->fmt, fmt, fmtLen + 1) != 0) {
+    return false; // stale
+  }
+  if(EXT_ARGS_HashMore(EXT_ARGS_HASH_INIT, img + sizeof(*h), h->size - sizeof(*h)) != h->checksum) {
+    return false;
+  }
+
+  uint32_t mask = h->aliasIndexMask;
+  if(!EXT_ARGS_ImageHas(h, h->posArgs, h->posArgsCount, sizeof(EXT_ARGS_ImagePosArg)) ||
+      !EXT_ARGS_ImageHas(h, h->groups, h->groupsCount, sizeof(EXT_ARGS_ImageGroup)) ||
+      !EXT_ARGS_ImageHas(h, h->floats, h->floatsCount, sizeof(EXT_ARGS_ImageFloat)) ||
+      !EXT_ARGS_ImageHas(h, h->sequence, h->sequenceCount, sizeof(EXT_ARGS_SequenceElement)) ||
+      mask >= h->size || (mask & (mask + 1)) != 0 || !EXT_ARGS_ImageHas(h, h->aliasIndex, mask + 1, sizeof(int))) {
+    return false;
+  }
+
+  // Only the rows with strings are rebuilt, the rest is used in place
+  char *base = img + h->fmt;
+  const EXT_ARGS_ImagePosArg *ipos = (const EXT_ARGS_ImagePosArg *)(img + h->posArgs);
+  EXT_ARGS_PosArg *posArgs = EXT_ARGS_Alloc(schema->mem, sizeof(*posArgs) * h->posArgsCount + 1);
+  if(!posArgs) {
+    longjmp(jbuf, EXT_ARGS_ERR_MEM);
+  }
+  schema->posArgs = posArgs;
+  for(uint32_t i = 0; i < h->posArgsCount; i++) {
+    if(ipos[i].str > fmtLen || ipos[i].len > fmtLen - ipos[i].str) {
+      return false;
+    }
+    posArgs[i] = (EXT_ARGS_PosArg){ipos[i].isOptional != 0, base + ipos[i].str, ipos[i].len};
+  }
+
+  const EXT_ARGS_ImageGroup *igr = (const EXT_ARGS_ImageGroup *)(img + h->groups);
+  EXT_ARGS_FloatArgsGroup *groups = EXT_ARGS_Alloc(schema->mem, sizeof(*groups) * h->groupsCount + 1);
+  if(!groups) {
+    longjmp(jbuf, EXT_ARGS_ERR_MEM);
+  }
+  schema->groups = groups;
+  for(uint32_t i = 0; i < h->groupsCount; i++) {
+    EXT_ARGS_ImageGroup g = igr[i];
+    if(g.valType > EXT_ARGS_T_BOOL || g.seqIdx >= h->sequenceCount || g.env > fmtLen || g.envLen > fmtLen - g.env) {
+      return false;
+    }
+    groups[i] = (EXT_ARGS_FloatArgsGroup){
+      .isOptional = (g.flags & EXT_ARGS_IMAGE_OPTIONAL) != 0,
+      .hasAssign = (g.flags & EXT_ARGS_IMAGE_ASSIGN) != 0,
+      .isAssignOptional = (g.flags & EXT_ARGS_IMAGE_ASSIGN_OPTIONAL) != 0,
+      .isRepeating = (g.flags & EXT_ARGS_IMAGE_REPEATING) != 0,
+      .aliasCount = g.aliasCount,
+      .valType = g.valType,
+      .seqIdx = g.seqIdx,
+      .env = base + g.env,
+      .envLen = g.envLen
+    };
+  }
+
+  const EXT_ARGS_ImageFloat *ifl = (const EXT_ARGS_ImageFloat *)(img + h->floats);
+  EXT_ARGS_FloatArg *floats = EXT_ARGS_Alloc(schema->mem, sizeof(*floats) * h->floatsCount + 1);
+  if(!floats) {
+    longjmp(jbuf, EXT_ARGS_ERR_MEM);
+  }
+  schema->floats = floats;
+  for(uint32_t i = 0; i < h->floatsCount; i++) {
+    if(ifl[i].str > fmtLen || ifl[i].len > fmtLen - ifl[i].str || ifl[i].groupIdx >= h->groupsCount) {
+      return false;
+    }
+    floats[i] = (EXT_ARGS_FloatArg){base + ifl[i].str, ifl[i].len, ifl[i].groupIdx};
+  }
+
+  const EXT_ARGS_SequenceElement *seq = (const EXT_ARGS_SequenceElement *)(img + h->sequence);
+  for(uint32_t i = 0; i < h->sequenceCount; i++) {
+    if(seq[i].idx < 0 || seq[i].idx >= (int)(seq[i].type == EXT_ARGS_ARG_POS ? h->posArgsCount : h->groupsCount)) {
+      return false;
+    }
+  }
+
+  // At least one empty slot, so lookups of unknown aliases stop
+  const int *index = (const int *)(img + h->aliasIndex);
+  bool hasEmpty = false;
+  for(uint32_t i = 0; i <= mask; i++) {
+    if(index[i] < -1 || index[i] >= (int)h->floatsCount) {
+      return false;
+    }
+    hasEmpty = hasEmpty || index[i] == -1;
+  }
+  if(!hasEmpty) {
+    return false;
+  }
+
+  schema->fmt = base;
+  schema->posArgsCount = h->posArgsCount;
+  schema->groupsCount = h->groupsCount;
+  schema->floatsCount = h->floatsCount;
+  schema->sequence = seq;
+  schema->sequenceCount = h->sequenceCount;
+  schema->varPosArgsEnabled = h->varPosArgsEnabled != 0;
+  schema->aliasIndex = index;
+  schema->aliasIndexMask = mask;
+  schema->trie = EXT_ARGS_BuildTrie(schema->mem, floats, schema->floatsCount);
+  schema->shortIndex = EXT_ARGS_BuildShortIndex(schema->mem, floats, schema->floatsCount);
+  if(!schema->trie || !schema->shortIndex) {
+    longjmp(jbuf, EXT_ARGS_ERR_MEM);
+  }
+  return true;
+}
+
+EXT_ARGS_API int ext_args_compile_cached(char *fmt, const char *path, const ext_args_allocator *allocator,
+    ext_args_schema **oschema, char **oerr) {
+  *oschema = NULL;
+  *oerr = NULL;
+
+  ext_args_schema *schema = EXT_ARGS_Calloc(allocator, 1, sizeof(*schema));
+  if(!schema) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  if(allocator) {
+    schema->allocator = *allocator;
+    schema->mem = &schema->allocator;
+  }
+
+  jmp_buf jbuf;
+  if(setjmp(jbuf) == EXT_ARGS_ERR_MEM) {
+    ext_args_schema_free(schema);
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  if(EXT_ARGS_ReadFile(schema->mem, jbuf, path, &schema->map) && EXT_ARGS_LoadImage(schema, fmt, jbuf)) {
+    *oschema = schema;
+    return EXT_ARGS_NO_ERR;
+  }
+  ext_args_schema_free(schema);
+
+  int res = ext_args_compile_ex(fmt, allocator, oschema, oerr);
+  if(res == EXT_ARGS_NO_ERR) {
+    char *err;
+    if(ext_args_schema_save(*oschema, path, &err) != EXT_ARGS_NO_ERR) {
+      EXT_ARGS_Free(allocator, err);
+    }
+  }
+  return res;
+}
+
+// Splits one argument into user input tokens, at most 3 of them. Returns
+// the tokens count or -1 for an ambiguous argument
+#ifdef EXT_ARGS_SSE2
+// Aligned loads never cross into the next page, so reading past the
+// terminating zero is harmless, but not to ASan and TSan
+#if defined(__SANITIZE_ADDRESS__)
+#define EXT_ARGS_NO_ASAN __attribute__((no_sanitize_address))
+#elif defined(__SANITIZE_THREAD__)
+#define EXT_ARGS_NO_ASAN __attribute__((no_sanitize_thread))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define EXT_ARGS_NO_ASAN __attribute__((no_sanitize_address))
+#elif __has_feature(thread_sanitizer)
+#define EXT_ARGS_NO_ASAN __attribute__((no_sanitize_thread))
+#endif
+#endif
+#ifndef EXT_ARGS_NO_ASAN
+#define EXT_ARGS_NO_ASAN
+#endif
+
+// Bit per byte of the aligned 16 at `p`: dashes and name characters
+EXT_ARGS_NO_ASAN static void EXT_ARGS_ClassifyBlock(const char *p, unsigned *dash, unsigned *name) {
+  __m128i c = _mm_load_si128((const __m128i *)p);
+  __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+  __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+  __m128i d = _mm_cmpeq_epi8(c, _mm_set1_epi8('-'));
+  __m128i n = _mm_or_si128(_mm_or_si128(alpha, digit), _mm_or_si128(d, _mm_cmpeq_epi8(c, _mm_set1_epi8('_'))));
+  *dash = _mm_movemask_epi8(d);
+  *name = _mm_movemask_epi8(n);
+}
+
+// Length of the float at the start of `s`, the same as `EXT_ARGS_ArgFloat`
+// accepts: dashes, a letter, name characters not ending with a dash. 0 when
+// there is none. One pass over 16 byte blocks finds the end of the dashes
+// run and then the end of the name
+static int EXT_ARGS_FloatLen(const char *s) {
+  int skew = (int)((uintptr_t)s & 15);
+  const char *p = s - skew;
+  unsigned dash, name;
+  EXT_ARGS_ClassifyBlock(p, &dash, &name);
+
+  // Positions before `s` count as dashes, so they're skipped
+  unsigned other = ~(dash | ((1u << skew) - 1)) & 0xffff;
+  while(!other) {
+    p += 16;
+    EXT_ARGS_ClassifyBlock(p, &dash, &name);
+    other = ~dash & 0xffff;
+  }
+  int i = (int)(p - s) + __builtin_ctz(other);
+  if(!i || !EXT_ARGS_IsAlpha(s[i])) {
+    return 0;
+  }
+
+  // The name goes on after the letter
+  int bit = i + 1 - (int)(p - s);
+  unsigned notName = 0;
+  if(bit < 16) {
+    notName = ~(name | ((1u << bit) - 1)) & 0xffff;
+  }
+  while(!notName) {
+    p += 16;
+    EXT_ARGS_ClassifyBlock(p, &dash, &name);
+    notName = ~name & 0xffff;
+  }
+  int end = (int)(p - s) + __builtin_ctz(notName);
+  return s[end - 1] == '-' ? 0 : end;
+}
+#else
+static int EXT_ARGS_FloatLen(const char *s) {
+  int i = 0;
+  while(s[i] == '-') {
+    i++;
+  }
+  if(!i || !EXT_ARGS_IsAlpha(s[i])) {
+    return 0;
+  }
+  i++;
+  while(EXT_ARGS_IsNameChar(s[i])) {
+    i++;
+  }
+  return s[i - 1] == '-' ? 0 : i;
+}
+#endif
+
+static int EXT_ARGS_LexArg(char *arg, EXT_ARGS_UTok *toks) {
+  int n = 0;
+  char *str;
+
+  int len = EXT_ARGS_FloatLen(arg);
+  if(len) {
+    toks[n++] = (EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_FLOAT, .str = arg, .len = len};
+    if(arg[len] != '=') {
+      return arg[len] == '\0' ? n : -1;
+    }
+    str = arg + len + 1;
+  } else if(arg[0] == '=') {
+    str = arg + 1;
+  } else {
+    if(arg[0] == '-' && arg[1] == '-') {
+      toks[n++] = (EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_EOI};
+    } else {
+      toks[n++] = (EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_VAL, .str = arg};
+    }
+    return n;
+  }
+
+  toks[n++] = (EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_EQL, .str = str - 1};
+  if(*str != '\0') {
+    toks[n++] = (EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_VAL, .str = str};
+  }
+  return n;
+}
+
+// Checks a float's value against its group, `groupIdx` must be set. Converts
+// typed values, so a bad value is found before anything is written
+static int EXT_ARGS_CheckValue(const ext_args_schema *schema, const EXT_ARGS_GroupState *groups,
+    const ext_args_allocator *mem, jmp_buf jbuf, bool defer, EXT_ARGS_UFloatArg *uf, char **oerr) {
+  const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[uf->groupIdx];
+  if(groups[uf->groupIdx].isUsed && !gr->isRepeating) {
+    *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "Same arguments provided multiple times: %.*s", uf->len, uf->str);
+    return EXT_ARGS_INPUT_ERR;
+  }
+
+  if(gr->hasAssign) {
+    if(!uf->assignVal && !gr->isAssignOptional) {
+      *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "\"%.*s\" argument requires a value", uf->len, uf->str);
+      return EXT_ARGS_INPUT_ERR;
+    }
+
+    if(uf->assignVal && gr->valType != EXT_ARGS_T_STR) {
+      switch(EXT_ARGS_Convert(gr->valType, uf->assignVal, &uf->val)) {
+        case EXT_ARGS_CONV_INVALID:
+          *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "Invalid value \"%s\" of \"%.*s\" argument",
+              uf->assignVal, uf->len, uf->str);
+          return EXT_ARGS_INPUT_ERR;
+
+        case EXT_ARGS_CONV_RANGE:
+          *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "Value \"%s\" of \"%.*s\" argument is out of range",
+              uf->assignVal, uf->len, uf->str);
+          return EXT_ARGS_INPUT_ERR;
+      }
+    }
+  } else { // assign not required
+    if(uf->assignVal) {
+      *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "\"%.*s\" argument does not require a value", uf->len, uf->str);
+      return EXT_ARGS_INPUT_ERR;
+    }
+  }
+
+  return EXT_ARGS_NO_ERR;
+}
+
+// Lists the long aliases starting with the ambiguous abbreviation
+static char *EXT_ARGS_AbbrevErr(const ext_args_schema *schema, const ext_args_allocator *mem, jmp_buf jbuf,
+    const EXT_ARGS_UFloatArg *uf) {
+  size_t size = 1;
+  for(int i = 0; i < schema->floatsCount; i++) {
+    EXT_ARGS_FloatArg f = schema->floats[i];
+    if(f.len > uf->len && strncmp(f.str, uf->str, uf->len) == 0) {
+      size += f.len + 2;
+    }
+  }
+  char *list = EXT_ARGS_Alloc(mem, size);
+  if(!list) {
+    longjmp(jbuf, EXT_ARGS_ERR_MEM);
+  }
+  char *p = list;
+  for(int i = 0; i < schema->floatsCount; i++) {
+    EXT_ARGS_FloatArg f = schema->floats[i];
+    if(f.len > uf->len && strncmp(f.str, uf->str, uf->len) == 0) {
+      p += sprintf(p, "%s%.*s", p == list ? "" : ", ", f.len, f.str);
+    }
+  }
+  char *err = EXT_ARGS_FmtErr(mem, jbuf, "Ambiguous argument \"%.*s\", it may be %s", uf->len, uf->str, list);
+  EXT_ARGS_Free(mem, list);
+  return err;
+}
+
+// Matches a float against the schema, sets `groupIdx` and checks the value
+static int EXT_ARGS_CheckFloat(const ext_args_schema *schema, const EXT_ARGS_GroupState *groups,
+    const ext_args_allocator *mem, jmp_buf jbuf, bool defer, bool abbrev, EXT_ARGS_UFloatArg *uf, char **oerr) {
+  int fi = EXT_ARGS_FindFloat(schema, uf->str, uf->len);
+  if(fi == -1 && abbrev) {
+    fi = EXT_ARGS_FindAbbrev(schema, uf->str, uf->len);
+    if(fi == EXT_ARGS_TRIE_AMBIGUOUS) {
+      *oerr = defer ? NULL : EXT_ARGS_AbbrevErr(schema, mem, jbuf, uf);
+      return EXT_ARGS_INPUT_ERR;
+    }
+  }
+  if(fi == -1) {
+    *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "Ambiguous argument \"%.*s\" provided", uf->len, uf->str);
+    return EXT_ARGS_INPUT_ERR;
+  }
+
+  uf->groupIdx = schema->floats[fi].groupIdx;
+  return EXT_ARGS_CheckValue(schema, groups, mem, jbuf, defer, uf, oerr);
+}
+
+// Takes a checked float resolved from the environment or a config file
+typedef void (*EXT_ARGS_TakeFn)(void *ctx, const EXT_ARGS_UFloatArg *uf);
+
+// Values of the groups not provided by user but set in a config file. The
+// same checks as for the command line apply, flags take boolean values
+static int EXT_ARGS_ResolveConfig(const ext_args_schema *schema, EXT_ARGS_GroupState *groups,
+    const ext_args_allocator *mem, jmp_buf jbuf, bool defer, const ext_args_config *cfg, EXT_ARGS_TakeFn take,
+    void *ctx, char **oerr) {
+  for(int i = 0; i < schema->groupsCount; i++) {
+    groups[i].isFromArgs = groups[i].isUsed;
+  }
+
+  for(int i = 0; i < cfg->entriesCount; i++) {
+    EXT_ARGS_ConfigEntry e = cfg->entries[i];
+
+    int fi;
+    if(e.key[0] == '-') {
+      fi = EXT_ARGS_FindFloat(schema, e.key, e.keyLen);
+    } else {
+      fi = EXT_ARGS_FindFloatPrefixed(schema, "--", e.key, e.keyLen);
+      if(fi == -1) {
+        fi = EXT_ARGS_FindFloatPrefixed(schema, "-", e.key, e.keyLen);
+      }
+    }
+    if(fi == -1) {
+      *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "Unknown config key \"%s\"", e.key);
+      return EXT_ARGS_INPUT_ERR;
+    }
+
+    int gi = schema->floats[fi].groupIdx;
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[gi];
+    EXT_ARGS_GroupState *st = &groups[gi];
+    if(st->isFromArgs) {
+      continue; // the command line and the environment win
+    }
+
+    EXT_ARGS_UFloatArg uf = {.str = e.key, .len = e.keyLen, .assignVal = e.val, .groupIdx = gi};
+    if(!gr->hasAssign && e.val) {
+      bool set;
+      if(EXT_ARGS_ConvBool(e.val, e.val + strlen(e.val), &set) != EXT_ARGS_CONV_OK) {
+        *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "Invalid value \"%s\" of \"%s\" argument", e.val, e.key);
+        return EXT_ARGS_INPUT_ERR;
+      }
+      if(!set) {
+        continue;
+      }
+      uf.assignVal = NULL;
+    }
+
+    int res = EXT_ARGS_CheckValue(schema, groups, mem, jbuf, defer, &uf, oerr);
+    if(res != EXT_ARGS_NO_ERR) {
+      return res;
+    }
+    st->isUsed = true;
+    st->usedCount++;
+    take(ctx, &uf);
+  }
+
+  return EXT_ARGS_NO_ERR;
+}
+
+// Values of the environment bound groups, indexed as the groups. NULL for
+// unset and empty variables, the first one in `envp` wins. The names are put
+// in a small hash table, then `envp` is walked once. False when the memory ends
+static bool EXT_ARGS_LookupEnv(const ext_args_schema *schema, char **envp, const ext_args_allocator *mem,
+    char **vals) {
+  int needed = 0;
+  for(int i = 0; i < schema->groupsCount; i++) {
+    vals[i] = NULL;
+    if(schema->groups[i].envLen) {
+      needed++;
+    }
+  }
+  if(!needed) {
+    return true;
+  }
+
+  int inl[EXT_ARGS_INLINE_SCHEMA * 2];
+  unsigned size = 8;
+  while(size < (unsigned)needed * 2) {
+    size *= 2;
+  }
+  int *index = inl;
+  if(size > sizeof(inl) / sizeof(*inl)) {
+    index = EXT_ARGS_Alloc(mem, sizeof(*index) * size);
+    if(!index) {
+      return false;
+    }
+  }
+  memset(index, -1, sizeof(*index) * size);
+
+  unsigned mask = size - 1;
+  for(int i = 0; i < schema->groupsCount; i++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[i];
+    if(gr->envLen) {
+      unsigned slot = EXT_ARGS_Hash(gr->env, gr->envLen) & mask;
+      while(index[slot] != -1) {
+        slot = (slot + 1) & mask;
+      }
+      index[slot] = i;
+    }
+  }
+
+  for(char **e = envp; *e; e++) {
+    char *eq = strchr(*e, '=');
+    if(!eq || eq[1] == '\0') {
+      continue;
+    }
+    int len = eq - *e;
+
+    unsigned slot = EXT_ARGS_Hash(*e, len) & mask;
+    for(int gi; (gi = index[slot]) != -1; slot = (slot + 1) & mask) {
+      const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[gi];
+      if(!vals[gi] && gr->envLen == len && strncmp(gr->env, *e, len) == 0) {
+        vals[gi] = eq + 1;
+      }
+    }
+  }
+
+  if(index != inl) {
+    EXT_ARGS_Free(mem, index);
+  }
+  return true;
+}
+
+// Values of the groups not provided by user but bound to environment
+// variables, `vals` comes from EXT_ARGS_LookupEnv. Env values count as
+// provided, the variable name is used as the argument name in errors
+static int EXT_ARGS_ResolveEnv(const ext_args_schema *schema, EXT_ARGS_GroupState *groups,
+    const ext_args_allocator *mem, jmp_buf jbuf, bool defer, char **vals, EXT_ARGS_TakeFn take, void *ctx,
+    char **oerr) {
+  for(int gi = 0; gi < schema->groupsCount; gi++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[gi];
+    EXT_ARGS_GroupState *st = &groups[gi];
+    if(!vals[gi] || st->isUsed) {
+      continue;
+    }
+
+    EXT_ARGS_UFloatArg uf = {.str = gr->env, .len = gr->envLen, .assignVal = vals[gi], .groupIdx = gi};
+    int res = EXT_ARGS_CheckValue(schema, groups, mem, jbuf, defer, &uf, oerr);
+    if(res != EXT_ARGS_NO_ERR) {
+      return res;
+    }
+    st->isUsed = true;
+    st->usedCount++;
+    take(ctx, &uf);
+  }
+
+  return EXT_ARGS_NO_ERR;
+}
+
+// Checks floats that specified but not provided and the positionals count
+static int EXT_ARGS_CheckMissing(const ext_args_schema *schema, const EXT_ARGS_GroupState *groups,
+    int posArgsCount, const ext_args_allocator *mem, jmp_buf jbuf, bool defer, char **oerr) {
+  for(int i = 0; i < schema->groupsCount; i++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[i];
+    if(!groups[i].isUsed) {
+      if(!gr->isOptional) {
+        for(int j = 0; j < schema->floatsCount; j++) {
+          EXT_ARGS_FloatArg fa = schema->floats[j];
+          if(fa.groupIdx == i) {
+            char *s = gr->aliasCount > 1 ? "(or alias) " : "";
+            *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "\"%.*s\" argument %srequired but not provided", fa.len, fa.str, s);
+            return EXT_ARGS_INPUT_ERR;
+          }
+        }
+      }
+    }
+  }
+
+  int manposArgsCount = 0;
+  for(int i = 0; i < schema->posArgsCount; i++) {
+    if(!schema->posArgs[i].isOptional) {
+      manposArgsCount += 1;
+    }
+  }
+
+  if(posArgsCount < manposArgsCount) {
+    *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "Not enough positional arguments provided");
+    return EXT_ARGS_INPUT_ERR;
+  }
+
+  if(!schema->varPosArgsEnabled) {
+    if(posArgsCount > schema->posArgsCount) {
+      *oerr = defer ? NULL : EXT_ARGS_FmtErr(mem, jbuf, "Too many positional arguments provided");
+      return EXT_ARGS_INPUT_ERR;
+    }
+  }
+
+  return EXT_ARGS_NO_ERR;
+}
+
+// Assigns a checked non repeating float to its var
+static void EXT_ARGS_FillFloat(const EXT_ARGS_FloatArgsGroup *gr, void *varPtr, const EXT_ARGS_UFloatArg *uf) {
+  if(!varPtr) {
+    return;
+  }
+
+  if(gr->hasAssign) {
+    if(gr->valType != EXT_ARGS_T_STR) {
+      // typed flag set without a value keeps the default
+      if(uf->assignVal) {
+        EXT_ARGS_StoreValue(gr->valType, varPtr, uf->val);
+      }
+    } else if(uf->assignVal) {
+      *((char **)varPtr) = uf->assignVal;
+    } else { // no value provided by user but the flag is set
+      *((char **)varPtr) = ext_args_no_value;
+    }
+  } else { // assign not required
+    *((bool *)varPtr) = true;
+  }
+}
+
+// Non repeating optional float not provided by user
+static void EXT_ARGS_FillDefault(const EXT_ARGS_FloatArgsGroup *gr, void *varPtr) {
+  if(!varPtr) {
+    return;
+  }
+
+  if(gr->hasAssign) {
+    // typed vars keep their defaults
+    if(gr->valType == EXT_ARGS_T_STR) {
+      *((char **)varPtr) = NULL;
+    }
+  } else {
+    *((bool *)varPtr) = false;
+  }
+}
+
+// Splits a response file in place. Arguments are separated by whitespace,
+// single quotes keep everything literally, double quotes and unquoted text
+// take backslash escapes. Every argument is zero terminated where it ends,
+// the writing position never passes the reading one. Returns the next
+// argument or NULL at the end
+static char *EXT_ARGS_NextRspArg(char **pos) {
+  char *r = *pos;
+  while(EXT_ARGS_IsSpace(*r)) {
+    r++;
+  }
+  if(*r == '\0') {
+    return NULL;
+  }
+
+  char *arg = r, *w = r;
+  char quote = 0;
+  for(; *r; r++) {
+    if(quote == '\'') {
+      if(*r == '\'') {
+        quote = 0;
+      } else {
+        *w++ = *r;
+      }
+    } else if(*r == '\\' && r[1] != '\0') {
+      *w++ = *++r;
+    } else if(quote == '"') {
+      if(*r == '"') {
+        quote = 0;
+      } else {
+        *w++ = *r;
+      }
+    } else if(*r == '\'' || *r == '"') {
+      quote = *r;
+    } else if(EXT_ARGS_IsSpace(*r)) {
+      r++;
+      break;
+    } else {
+      *w++ = *r;
+    }
+  }
+  *w = '\0';
+  *pos = r;
+  return arg;
+}
+
+// Lexes one argument into `inp->tokens`, expanding response files. Returns
+// true after "--", the rest of the input is ignored then
+static bool EXT_ARGS_LexInput(EXT_ARGS_Inp *inp, const ext_args_options *opts, char *arg, int depth,
+    int *res, char **oerr) {
+  ext_args_response_files *rf = opts ? opts->responseFiles : NULL;
+
+  if(rf && arg[0] == '@' && arg[1] != '\0') {
+    int maxDepth = rf->maxDepth ? rf->maxDepth : EXT_ARGS_RESPONSE_DEPTH;
+    if(depth >= maxDepth) {
+      *res = EXT_ARGS_INPUT_ERR;
+      *oerr = inp->deferErr ? NULL : EXT_ARGS_FmtErr(inp->mem, inp->jbuf, "Response files nested too deep \"%s\"", arg);
+      return true;
+    }
 
-// Array of strings
-typedef struct {
-  EXT_ARGS_DYN_ARY_FIELDS(char *, ary);
-} EXT_ARGS_Ary;
+    // The files outlive the parse, so they never go to the arena. The stats
+    // allocator isn't kept either, it points into the parse's state
+    if(!rf->maps) {
+      rf->mem = NULL;
+      if(opts->allocator) {
+        rf->allocator = *opts->allocator;
+        rf->mem = &rf->allocator;
+      }
+    }
 
-typedef struct {
-  EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_UTok, tokens);
-  EXT_ARGS_DYN_ARY_FIELDS(EXT_ARGS_UFloatArg, floats);
-  EXT_ARGS_DYN_ARY_FIELDS(char *, posArgs);
-} EXT_ARGS_Inp;
+    // Saved before reading, so the file is released even when the memory ends
+    EXT_ARGS_DYN_ARY_SAVE(rf, maps, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_Mapping){0}), rf->mem, inp->jbuf);
+    EXT_ARGS_Mapping *m = &rf->maps[rf->mapsCount - 1];
+    if(!EXT_ARGS_ReadFile(rf->mem, inp->jbuf, arg + 1, m)) {
+      rf->mapsCount--;
+      *res = EXT_ARGS_INPUT_ERR;
+      *oerr = inp->deferErr ? NULL : EXT_ARGS_FmtErr(inp->mem, inp->jbuf, "Can't read response file \"%s\"", arg + 1);
+      return true;
+    }
 
-static char *EXT_ARGS_FmtErr(jmp_buf jbuf, char* fmt, ...) {
-  va_list ap;
-  va_start(ap, fmt);
-  int len = vsnprintf(&(char){0}, 1, fmt, ap);
-  va_end(ap);
+    char *pos = m->addr, *rarg;
+    while((rarg = EXT_ARGS_NextRspArg(&pos))) {
+      if(EXT_ARGS_LexInput(inp, opts, rarg, depth + 1, res, oerr)) {
+        return true;
+      }
+    }
+    return false;
+  }
 
-  char *str = malloc(len + 1);
-  if (!str) {
-    longjmp(jbuf, EXT_ARGS_ERR_MEM); \
+  EXT_ARGS_UTok toks[3];
+  int n = EXT_ARGS_LexArg(arg, toks);
+  if(n == -1) {
+    *res = EXT_ARGS_INPUT_ERR;
+    *oerr = inp->deferErr ? NULL : EXT_ARGS_FmtErr(inp->mem, inp->jbuf, "Ambiguous argument \"%s\"", arg);
+    return true;
   }
+  for(int j = 0; j < n; j++) {
+    EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, toks[j], inp->mem, inp->jbuf);
+  }
+  return toks[n - 1].type == EXT_ARGS_UTOK_EOI;
+}
 
-  va_start(ap, fmt);
-  vsnprintf(str, len + 1, fmt, ap);
-  va_end(ap);
-  return str;
+#ifdef EXT_ARGS_STATS
+// Ends the current phase of the parse, `next` starts
+static void EXT_ARGS_Phase(EXT_ARGS_Inp *inp, int next) {
+  uint64_t now = EXT_ARGS_Now();
+  inp->stats.ticks[inp->phase] += now - inp->lap;
+  inp->lap = now;
+  inp->phase = next;
+}
+#define EXT_ARGS_PHASE(inp, next) EXT_ARGS_Phase(inp, next)
+#else
+#define EXT_ARGS_PHASE(inp, next) ((void)0)
+#endif
+
+// Saves a float resolved from the environment or a config file with the
+// ones from the command line
+static void EXT_ARGS_InpTake(void *ctx, const EXT_ARGS_UFloatArg *uf) {
+  EXT_ARGS_Inp *inp = ctx;
+  EXT_ARGS_DYN_ARY_SAVE(inp, floats, EXT_ARGS_PREALLOC, 0, *uf, inp->mem, inp->jbuf);
+}
+
+// Variables come either from `ap` or, with `bound`, from the fields of `dst`.
+// Without both the input is only validated and the given groups are marked
+// in `used` when it's not NULL. `deferErr` leaves the messages to the caller.
+// `envVals` from EXT_ARGS_LookupEnv is shared by a batch, NULL looks it up
+static int EXT_ARGS_Parse(const ext_args_schema *schema, const ext_args_options *opts,
+    int argc, char *argv[], const ext_args_bound *bound, char *dst, va_list *ap, uint64_t *used, bool deferErr,
+    char **envVals, char **oerr) {
+  EXT_ARGS_Inp *inp = &(EXT_ARGS_Inp){.deferErr = deferErr};
+  int res = EXT_ARGS_NO_ERR;
+  *oerr = NULL;
+
+  if(opts) {
+    if(opts->arena) {
+      inp->arenaMem = ext_args_arena_allocator(opts->arena);
+      inp->mem = &inp->arenaMem;
+    } else {
+      inp->mem = opts->allocator;
+    }
+  }
+
+#ifdef EXT_ARGS_STATS
+  // Allocations are counted on the way to the caller's allocator
+  inp->statsMem = (EXT_ARGS_StatsMem){.mem = inp->mem, .stats = &inp->stats};
+  inp->statsAllocator = (ext_args_allocator){
+    EXT_ARGS_StatsAlloc, EXT_ARGS_StatsRealloc, EXT_ARGS_StatsFree, &inp->statsMem
+  };
+  inp->mem = &inp->statsAllocator;
+  inp->phase = EXT_ARGS_PHASE_LEX;
+  inp->lap = EXT_ARGS_Now();
+#endif
+
+  if(setjmp(inp->jbuf) == EXT_ARGS_ERR_MEM) {
+    res = EXT_ARGS_NO_MEM_ERR;
+    *oerr = NULL;
+    goto done;
+  }
+
+  EXT_ARGS_DYN_ARY_USE_INLINE(inp, tokens, inp->inl.tokens);
+  EXT_ARGS_DYN_ARY_USE_INLINE(inp, floats, inp->inl.floats);
+  EXT_ARGS_DYN_ARY_USE_INLINE(inp, posArgs, inp->inl.posArgs);
+
+  inp->groups = inp->inl.groups;
+  if(schema->groupsCount > EXT_ARGS_INLINE_SCHEMA) {
+    inp->groups = EXT_ARGS_Calloc(inp->mem, schema->groupsCount, sizeof(*inp->groups));
+    if(!inp->groups) {
+      longjmp(inp->jbuf, EXT_ARGS_ERR_MEM);
+    }
+  }
+  inp->posArgsVarPtrs = inp->inl.posArgsVarPtrs;
+  if(schema->posArgsCount > EXT_ARGS_INLINE_SCHEMA) {
+    inp->posArgsVarPtrs = EXT_ARGS_Calloc(inp->mem, schema->posArgsCount, sizeof(*inp->posArgsVarPtrs));
+    if(!inp->posArgsVarPtrs) {
+      longjmp(inp->jbuf, EXT_ARGS_ERR_MEM);
+    }
+  }
+
+  // Parse User's input
+  //
+  // Lexing
+
+  // Every argument gives at most one float and at most one positional, and
+  // usually one token
+  if(argc > 1) {
+    EXT_ARGS_DYN_ARY_RESERVE(inp, tokens, argc, inp->mem, inp->jbuf);
+    EXT_ARGS_DYN_ARY_RESERVE(inp, floats, argc - 1, inp->mem, inp->jbuf);
+    EXT_ARGS_DYN_ARY_RESERVE(inp, posArgs, argc - 1, inp->mem, inp->jbuf);
+  }
+
+  for(int i = 1; i < argc; i++) {
+    if(EXT_ARGS_LexInput(inp, opts, argv[i], 0, &res, oerr)) {
+      break;
+    }
+  }
+  if(res != EXT_ARGS_NO_ERR) {
+    goto done;
+  }
+
+  if(inp->tokensCount == 0 || inp->tokens[inp->tokensCount - 1].type != EXT_ARGS_UTOK_EOI) {
+    EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_EOI}), inp->mem, inp->jbuf);
+  }
+
+  // Parsing
+
+  EXT_ARGS_PHASE(inp, EXT_ARGS_PHASE_MATCH);
+  int i = 0;
+  for(;;) {
+    if(inp->tokens[i].type == EXT_ARGS_UTOK_EOI) {
+      break;
+    }
+
+    if(inp->tokens[i].type == EXT_ARGS_UTOK_FLOAT) {
+      EXT_ARGS_UTok tok = inp->tokens[i];
+      int n = opts && opts->cluster ? EXT_ARGS_ClusterLen(schema, tok.str, tok.len) : 0;
+      for(int k = 1; k <= n; k++) { // each letter becomes its alias, the last one takes the value
+        EXT_ARGS_FloatArg f = schema->floats[schema->shortIndex[(unsigned char)inp->tokens[i].str[k]]];
+        tok.str = f.str;
+        tok.len = f.len;
+        if(k < n) {
+          EXT_ARGS_DYN_ARY_SAVE(inp, floats, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UFloatArg){
+            .str = tok.str,
+            .len = tok.len
+          }), inp->mem, inp->jbuf);
+        }
+      }
+      EXT_ARGS_DYN_ARY_SAVE(inp, floats, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UFloatArg){
+        .str = tok.str,
+        .len = tok.len
+      }), inp->mem, inp->jbuf);
+      EXT_ARGS_UFloatArg *arg = &inp->floats[inp->floatsCount - 1];
+
+      i++;
+
+      if(inp->tokens[i].type == EXT_ARGS_UTOK_EQL) {
+        i++;
+        if(inp->tokens[i].type != EXT_ARGS_UTOK_VAL) {
+          res = EXT_ARGS_INPUT_ERR;
+          *oerr = inp->deferErr ? NULL : EXT_ARGS_FmtErr(inp->mem, inp->jbuf, "A value expected \"%s\"", inp->tokens[i - 2].str);
+          goto done;
+        }
+        arg->assignVal = inp->tokens[i].str;
+
+        i++;
+      }
+      continue;
+    }
+
+    if(inp->tokens[i].type == EXT_ARGS_UTOK_VAL) {
+      EXT_ARGS_DYN_ARY_SAVE(inp, posArgs, EXT_ARGS_PREALLOC, 0, inp->tokens[i].str, inp->mem, inp->jbuf);
+      i++;
+      continue;
+    }
+
+    res = EXT_ARGS_INPUT_ERR;
+    *oerr = inp->deferErr ? NULL : EXT_ARGS_FmtErr(inp->mem, inp->jbuf, "Unexpected input \"%s\"", inp->tokens[i].str);
+    goto done;
+  }
+
+  if(inp->tokens[i].type != EXT_ARGS_UTOK_EOI) {
+    res = EXT_ARGS_INPUT_ERR;
+    *oerr = inp->deferErr ? NULL : EXT_ARGS_FmtErr(inp->mem, inp->jbuf, "Unexpected input \"%s\"", inp->tokens[i].str);
+    goto done;
+  }
+
+  // Validations
+
+  EXT_ARGS_PHASE(inp, EXT_ARGS_PHASE_VALIDATE);
+  for(int i = 0; i < inp->floatsCount; i++) {
+    EXT_ARGS_UFloatArg *uf = &inp->floats[i];
+    res = EXT_ARGS_CheckFloat(schema, inp->groups, inp->mem, inp->jbuf, inp->deferErr, opts && opts->abbrev, uf, oerr);
+    if(res != EXT_ARGS_NO_ERR) {
+      goto done;
+    }
+
+    EXT_ARGS_GroupState *st = &inp->groups[uf->groupIdx];
+    st->isUsed = true;
+    st->usedCount++;
+  }
+
+  // Command line > environment > config file > defaults
+  char **vals = envVals;
+  if(!vals) {
+    vals = inp->inl.envVals;
+    if(schema->groupsCount > EXT_ARGS_INLINE_SCHEMA) {
+      vals = inp->envVals = EXT_ARGS_Alloc(inp->mem, sizeof(*vals) * schema->groupsCount);
+    }
+    char **envp = opts && opts->envp ? opts->envp : EXT_ARGS_ENVIRON;
+    if(!vals || !EXT_ARGS_LookupEnv(schema, envp, inp->mem, vals)) {
+      longjmp(inp->jbuf, EXT_ARGS_ERR_MEM);
+    }
+  }
+  res = EXT_ARGS_ResolveEnv(schema, inp->groups, inp->mem, inp->jbuf, inp->deferErr, vals, EXT_ARGS_InpTake,
+      inp, oerr);
+  if(res != EXT_ARGS_NO_ERR) {
+    goto done;
+  }
+
+  if(opts && opts->config) {
+    res = EXT_ARGS_ResolveConfig(schema, inp->groups, inp->mem, inp->jbuf, inp->deferErr, opts->config,
+        EXT_ARGS_InpTake, inp, oerr);
+    if(res != EXT_ARGS_NO_ERR) {
+      goto done;
+    }
+  }
+
+  res = EXT_ARGS_CheckMissing(schema, inp->groups, inp->posArgsCount, inp->mem, inp->jbuf, inp->deferErr, oerr);
+  if(res != EXT_ARGS_NO_ERR) {
+    goto done;
+  }
+
+  if(!bound && !ap) {
+    for(int i = 0; used && i < schema->groupsCount; i++) {
+      if(inp->groups[i].isUsed) {
+        used[i / 64] |= (uint64_t)1 << (i % 64);
+      }
+    }
+    goto done;
+  }
+
+  // Get pointers to user passed vars
+
+  EXT_ARGS_PHASE(inp, EXT_ARGS_PHASE_FILL);
+
+  if(bound) {
+    const size_t *offs = bound->offsets;
+    for(int i = 0; i < schema->groupsCount; i++) {
+      inp->groups[i].varPtr = offs[i] == EXT_ARGS_UNBOUND ? NULL : dst + offs[i];
+    }
+    offs += schema->groupsCount;
+    for(int i = 0; i < schema->posArgsCount; i++) {
+      inp->posArgsVarPtrs[i] = offs[i] == EXT_ARGS_UNBOUND ? NULL : dst + offs[i];
+    }
+    offs += schema->posArgsCount;
+    inp->varPosArgsVarPtr = *offs == EXT_ARGS_UNBOUND ? NULL : dst + *offs;
+  } else {
+    for(int i = 0; i < schema->sequenceCount; i++) {
+      EXT_ARGS_SequenceElement sq = schema->sequence[i];
+      void *p = va_arg(*ap, void *);
+      if(sq.type == EXT_ARGS_ARG_POS) {
+        inp->posArgsVarPtrs[sq.idx] = p;
+      } else {
+        inp->groups[sq.idx].varPtr = p;
+      }
+    }
+    if(schema->varPosArgsEnabled) {
+      inp->varPosArgsVarPtr = va_arg(*ap, void *);
+    }
+  }
+
+  // Vars filling, assings
+
+  ext_args_emit_fn emit = opts ? opts->emit : NULL;
+
+  for(int i = 0; i < inp->floatsCount; i++) {
+    EXT_ARGS_UFloatArg uf = inp->floats[i];
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[uf.groupIdx];
+    EXT_ARGS_GroupState *st = &inp->groups[uf.groupIdx];
+
+    if(gr->isRepeating) {
+      // for repeating assign always exists
+      if(emit) {
+        emit(opts->ud, gr->seqIdx, uf.str, uf.len, uf.assignVal);
+      } else if(st->varPtr) {
+        EXT_ARGS_DYN_ARY_RESERVE(st, ary, st->usedCount + 1, inp->mem, inp->jbuf);
+        EXT_ARGS_DYN_ARY_SAVE(st, ary, EXT_ARGS_PREALLOC, 1, uf.assignVal, inp->mem, inp->jbuf);
+        st->ary[st->aryCount] = NULL;
+        *((char ***)st->varPtr) = st->ary;
+      }
+
+    } else {
+      EXT_ARGS_FillFloat(gr, st->varPtr, &uf);
+    }
+  }
+
+  // filling floats that specified but not provided
+  for(int i = 0; i < schema->groupsCount; i++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[i];
+    EXT_ARGS_GroupState *st = &inp->groups[i];
+    if(!st->isUsed) {
+      if(gr->isOptional) {
+        if(gr->isRepeating) {
+          if(st->varPtr && !emit) {
+            EXT_ARGS_DYN_ARY_SAVE(st, ary, 1, 0, NULL, inp->mem, inp->jbuf);
+            *((char ***)st->varPtr) = st->ary;
+          }
+        } else {
+          EXT_ARGS_FillDefault(gr, st->varPtr);
+        }
+      }
+    }
+  }
+
+  // NULLing optionals not provided by user
+  for(int i = inp->posArgsCount; i < schema->posArgsCount; i++) {
+    char *p = inp->posArgsVarPtrs[i];
+    if(p) {
+      *((char **)p) = NULL;
+    }
+  }
+
+  { // filling posArgs vars
+    EXT_ARGS_Ary *optsVarAry = &(EXT_ARGS_Ary){0};
+
+    for(int i = 0; i < inp->posArgsCount; i++) {
+      if(i < schema->posArgsCount) {
+        void *p = inp->posArgsVarPtrs[i];
+        if(p) {
+          *((char **)p) = inp->posArgs[i];
+        }
+      } else {
+        // Filling opts
+
+        if(emit) {
+          emit(opts->ud, schema->sequenceCount, NULL, 0, inp->posArgs[i]);
+          continue;
+        }
+
+        if(!inp->varPosArgsVarPtr) {
+          // No need to create an array and assign anything
+          break;
+        }
+
+        EXT_ARGS_DYN_ARY_RESERVE(optsVarAry, ary, inp->posArgsCount - schema->posArgsCount + 1, inp->mem, inp->jbuf);
+        EXT_ARGS_DYN_ARY_SAVE(optsVarAry, ary, EXT_ARGS_PREALLOC, 1, inp->posArgs[i], inp->mem, inp->jbuf);
+        optsVarAry->ary[optsVarAry->aryCount] = NULL;
+        if(inp->varPosArgsVarPtr) {
+          *((char ***)inp->varPosArgsVarPtr) = optsVarAry->ary;
+        }
+      }
+    }
+
+    // Filling optional Pos args for which values not provided by user,
+    // like c and d in this schema: a b [c] [d]
+    for(int i = inp->posArgsCount; i < schema->posArgsCount; i++) {
+      void *p = inp->posArgsVarPtrs[i];
+      if(p) {
+        *((char **)p) = NULL;
+      }
+    }
+
+    // No external pos args provided, let's return an empty array
+    if(schema->varPosArgsEnabled && !optsVarAry->ary && !emit) {
+      if(inp->varPosArgsVarPtr) {
+        char ***p = inp->varPosArgsVarPtr;
+        *p = EXT_ARGS_Calloc(inp->mem, 1, sizeof(*p));
+        if(!(*p)) {
+          longjmp(inp->jbuf, EXT_ARGS_ERR_MEM);
+        }
+        **p = NULL;
+      }
+    }
+  }
+
+done:
+  EXT_ARGS_DYN_ARY_FREE(inp, tokens, inp->mem);
+  EXT_ARGS_DYN_ARY_FREE(inp, floats, inp->mem);
+  EXT_ARGS_DYN_ARY_FREE(inp, posArgs, inp->mem);
+  if(inp->groups != inp->inl.groups) {
+    EXT_ARGS_Free(inp->mem, inp->groups);
+  }
+  if(inp->posArgsVarPtrs != inp->inl.posArgsVarPtrs) {
+    EXT_ARGS_Free(inp->mem, inp->posArgsVarPtrs);
+  }
+  EXT_ARGS_Free(inp->mem, inp->envVals);
+
+#ifdef EXT_ARGS_STATS
+  EXT_ARGS_Phase(inp, inp->phase);
+  inp->stats.parses = 1;
+  inp->stats.tokens = inp->tokensCount;
+  inp->stats.floats = inp->floatsCount;
+  inp->stats.posArgs = inp->posArgsCount;
+  if(opts && opts->stats) {
+    EXT_ARGS_StatsAdd(opts->stats, &inp->stats, false);
+  }
+  EXT_ARGS_StatsAdd(&EXT_ARGS_Totals, &inp->stats, true);
+#endif
+
+  return res;
+}
+
+EXT_ARGS_API int ext_args_parse_ex(const ext_args_schema *schema, const ext_args_options *opts,
+    int argc, char *argv[], va_list ap, char **oerr) {
+  va_list cp;
+  va_copy(cp, ap);
+  int res = EXT_ARGS_Parse(schema, opts, argc, argv, NULL, NULL, &cp, NULL, false, NULL, oerr);
+  va_end(cp);
+  return res;
+}
+
+EXT_ARGS_API int ext_args_parse_into(const ext_args_bound *bound, const ext_args_options *opts,
+    int argc, char *argv[], void *dst, char **oerr) {
+  return EXT_ARGS_Parse(bound->schema, opts, argc, argv, bound, dst, NULL, NULL, false, NULL, oerr);
+}
+
+EXT_ARGS_API int ext_args_parse(const ext_args_schema *schema, int argc, char *argv[], va_list ap, char **oerr) {
+  return ext_args_parse_ex(schema, NULL, argc, argv, ap, oerr);
+}
+
+EXT_ARGS_API int ext_args_conv_int(const char *str, long long *out) {
+  return EXT_ARGS_ConvInt(str, str + strlen(str), out);
+}
+
+EXT_ARGS_API int ext_args_conv_uint(const char *str, unsigned long long *out) {
+  return EXT_ARGS_ConvUInt(str, str + strlen(str), out);
+}
+
+EXT_ARGS_API int ext_args_conv_f64(const char *str, double *out) {
+  return EXT_ARGS_ConvF64(str, str + strlen(str), out);
+}
+
+EXT_ARGS_API int ext_args_conv_size(const char *str, size_t *out) {
+  return EXT_ARGS_ConvSize(str, str + strlen(str), out);
+}
+
+EXT_ARGS_API int ext_args_conv_duration(const char *str, double *out) {
+  return EXT_ARGS_ConvDuration(str, str + strlen(str), out);
+}
+
+EXT_ARGS_API int ext_args_conv_bool(const char *str, bool *out) {
+  return EXT_ARGS_ConvBool(str, str + strlen(str), out);
+}
+
+EXT_ARGS_API int ext_args_batch_words(const ext_args_schema *schema) {
+  return (schema->groupsCount + 63) / 64;
+}
+
+// Scratch of one batch validation, reused for all the vectors it checks
+typedef struct {
+  const ext_args_allocator *mem;
+  char *buf;
+  size_t size;
+  ext_args_arena arena;
+  ext_args_options opts;
+} EXT_ARGS_BatchScratch;
+
+// The scratch must not move after this, its options point to its arena
+static bool EXT_ARGS_BatchInit(EXT_ARGS_BatchScratch *bs, const ext_args_options *opts) {
+  bs->mem = opts ? opts->allocator : NULL;
+  bs->size = EXT_ARGS_BATCH_ARENA;
+  bs->buf = EXT_ARGS_Alloc(bs->mem, bs->size);
+  ext_args_arena_init(&bs->arena, bs->buf, bs->size);
+
+  bs->opts = opts ? *opts : (ext_args_options){0};
+  bs->opts.arena = &bs->arena;
+  bs->opts.emit = NULL;
+  bs->opts.responseFiles = NULL;
+  return bs->buf != NULL;
+}
+
+// Environment of a batch, looked up once for all its vectors. `inl` has
+// EXT_ARGS_INLINE_SCHEMA entries. NULL when the memory ends
+static char **EXT_ARGS_BatchEnv(const ext_args_schema *schema, const ext_args_options *opts, char **inl) {
+  const ext_args_allocator *mem = opts ? opts->allocator : NULL;
+  char **vals = inl;
+  if(schema->groupsCount > EXT_ARGS_INLINE_SCHEMA) {
+    vals = EXT_ARGS_Alloc(mem, sizeof(*vals) * schema->groupsCount);
+    if(!vals) {
+      return NULL;
+    }
+  }
+  if(!EXT_ARGS_LookupEnv(schema, opts && opts->envp ? opts->envp : EXT_ARGS_ENVIRON, mem, vals)) {
+    if(vals != inl) {
+      EXT_ARGS_Free(mem, vals);
+    }
+    return NULL;
+  }
+  return vals;
+}
+
+// Validates the vectors from `lo` to `hi`, false when the memory ends
+static bool EXT_ARGS_BatchRun(EXT_ARGS_BatchScratch *bs, const ext_args_schema *schema, int lo, int hi,
+    const int *argcs, char **argvs[], char **envVals, ext_args_batch_out *out) {
+  int words = ext_args_batch_words(schema);
+  for(int i = lo; i < hi; i++) {
+    uint64_t *used = out->used ? out->used + (size_t)i * words : NULL;
+    char *err;
+    for(;;) {
+      if(used) {
+        memset(used, 0, sizeof(*used) * words);
+      }
+      ext_args_arena_reset(&bs->arena);
+      out->status[i] = EXT_ARGS_Parse(schema, &bs->opts, argcs[i], argvs[i], NULL, NULL, NULL, used, true, envVals, &err);
+      if(out->status[i] != EXT_ARGS_NO_MEM_ERR) {
+        break;
+      }
+
+      // The vector doesn't fit, it's validated again in a bigger arena
+      EXT_ARGS_Free(bs->mem, bs->buf);
+      bs->buf = bs->size <= SIZE_MAX / 2 ? EXT_ARGS_Alloc(bs->mem, bs->size *= 2) : NULL;
+      if(!bs->buf) {
+        return false;
+      }
+      ext_args_arena_init(&bs->arena, bs->buf, bs->size);
+    }
+  }
+  return true;
 }
 
-enum {
-  EXT_ARGS_NO_ERR,
-  EXT_ARGS_NO_MEM_ERR,
-  EXT_ARGS_SCHEMA_ERR,
-  EXT_ARGS_INPUT_ERR
-};
+EXT_ARGS_API int ext_args_parse_batch(const ext_args_schema *schema, const ext_args_options *opts, int n,
+    const int *argcs, char **argvs[], ext_args_batch_out *out) {
+  char *inlEnv[EXT_ARGS_INLINE_SCHEMA];
+  char **envVals = EXT_ARGS_BatchEnv(schema, opts, inlEnv);
+  if(!envVals) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+
+  EXT_ARGS_BatchScratch bs;
+  bool ok = EXT_ARGS_BatchInit(&bs, opts) && EXT_ARGS_BatchRun(&bs, schema, 0, n, argcs, argvs, envVals, out);
+  EXT_ARGS_Free(bs.mem, bs.buf);
+  if(envVals != inlEnv) {
+    EXT_ARGS_Free(bs.mem, envVals);
+  }
+  return ok ? EXT_ARGS_NO_ERR : EXT_ARGS_NO_MEM_ERR;
+}
 
-static int ext_args(int argc, char *argv[], char *fmt, va_list ap, char **oerr) {
-  EXT_ARGS_Parser prs = {.str = fmt};
-  EXT_ARGS_Inp *inp = &(EXT_ARGS_Inp){0};
-  int res = EXT_ARGS_NO_ERR;
+EXT_ARGS_API int ext_args_batch_error(const ext_args_schema *schema, const ext_args_options *opts,
+    int argc, char *argv[], char **oerr) {
+  ext_args_options eo = opts ? *opts : (ext_args_options){0};
+  eo.emit = NULL;
+  eo.responseFiles = NULL;
+  return EXT_ARGS_Parse(schema, &eo, argc, argv, NULL, NULL, NULL, NULL, false, NULL, oerr);
+}
 
-  int jval = setjmp(prs.jbuf);
-  switch(jval) {
-    case 0:
-      EXT_ARGS_Synopsis(&prs);
-      break;
+#ifdef EXT_ARGS_THREADS
 
-    case EXT_ARGS_ERR_LEX:
-      res = EXT_ARGS_SCHEMA_ERR;
-      *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Schema lexing error, starting from \"%s\"", prs.errStart);
-      goto done;
+// Range of the vectors left to a worker: the start in the low half and the
+// end in the high half of one word, so both change in one compare and swap
+#define EXT_ARGS_RANGE(lo, hi) ((uint64_t)(uint32_t)(lo) | (uint64_t)(uint32_t)(hi) << 32)
+#define EXT_ARGS_RANGE_LO(r) ((int)(uint32_t)(r))
+#define EXT_ARGS_RANGE_HI(r) ((int)((r) >> 32))
 
-    case EXT_ARGS_ERR_PARSE:
-      res = EXT_ARGS_SCHEMA_ERR;
-      *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Schema parsing error. Expected %s but received %s, starting from \"%s\"",
-          EXT_ARGS_TokTypeToName(prs.expTokType), EXT_ARGS_TokTypeToName(prs.unexpTokType), prs.errStart);
-      goto done;
+typedef struct EXT_ARGS_BatchPool EXT_ARGS_BatchPool;
 
-    case EXT_ARGS_ERR_MEM:
-      res = EXT_ARGS_NO_MEM_ERR;
-      *oerr = NULL;
-      goto done;
-  }
+typedef struct {
+  char pad0[64]; // keeps `range` off the cache lines written by the neighbours
+  uint64_t range;
+  char pad1[64];
+  EXT_ARGS_BatchScratch scratch;
+  EXT_ARGS_BatchPool *pool;
+  int idx;
+  pthread_t thread;
+  bool isStarted;
+} EXT_ARGS_BatchWorker;
+
+struct EXT_ARGS_BatchPool {
+  const ext_args_schema *schema;
+  const int *argcs;
+  char ***argvs;
+  char **envVals;
+  ext_args_batch_out *out;
+  EXT_ARGS_BatchWorker *workers;
+  int count;
+  int failed;
+};
 
-  // Additional schema validations
-  if(prs.posArgsCount > 1) {
-    for(int i = 0; i < prs.posArgsCount - 1; i++) {
-      // Schema like this is not allowed: "[a] b". This is ok: "a [b]"
-      if(prs.posArgs[i].isOptional && !prs.posArgs[i + 1].isOptional) {
-        res = EXT_ARGS_SCHEMA_ERR;
-        *oerr = EXT_ARGS_FmtErr(prs.jbuf, "All optional non-flag arguments must be chained on the schema's right side");
-        goto done;
-      }
+// Takes a chunk from the front of the worker's own range
+static bool EXT_ARGS_TakeOwn(EXT_ARGS_BatchWorker *w, int *lo, int *hi) {
+  uint64_t r = __atomic_load_n(&w->range, __ATOMIC_ACQUIRE);
+  for(;;) {
+    int l = EXT_ARGS_RANGE_LO(r), h = EXT_ARGS_RANGE_HI(r);
+    if(l >= h) {
+      return false;
+    }
+    int e = h - l > EXT_ARGS_BATCH_CHUNK ? l + EXT_ARGS_BATCH_CHUNK : h;
+    if(__atomic_compare_exchange_n(&w->range, &r, EXT_ARGS_RANGE(e, h), false, __ATOMIC_ACQ_REL,
+        __ATOMIC_ACQUIRE)) {
+      *lo = l;
+      *hi = e;
+      return true;
     }
   }
+}
 
-  // Parse User's input
-  //
-  // Lexing
-
-  for(int i = 1; i < argc; i++) {
-    char *bk = argv[i];
-    EXT_ARGS_Parser *ipr = &(EXT_ARGS_Parser){.str = bk};
-
-    if(EXT_ARGS_ArgFloat(ipr)) {
-      EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){
-        .type = EXT_ARGS_UTOK_FLOAT, .str = bk, .len = EXT_ARGS_Distance(ipr, bk)}
-      ), prs.jbuf);
-
-      if(EXT_ARGS_Char('=', ipr)) {
-        char *str = EXT_ARGS_CurrentPos(ipr);
-        EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_EQL, .str = str - 1}), prs.jbuf);
-        if(*str != '\0') {
-          EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_VAL, .str = str}), prs.jbuf);
-        }
-        continue;
+// Moves the back half of another worker's range to the empty range of `w`
+static bool EXT_ARGS_Steal(EXT_ARGS_BatchWorker *w) {
+  EXT_ARGS_BatchPool *pool = w->pool;
+  for(int k = 1; k < pool->count; k++) {
+    EXT_ARGS_BatchWorker *v = &pool->workers[(w->idx + k) % pool->count];
+    uint64_t r = __atomic_load_n(&v->range, __ATOMIC_ACQUIRE);
+    for(;;) {
+      int l = EXT_ARGS_RANGE_LO(r), h = EXT_ARGS_RANGE_HI(r);
+      if(l >= h) {
+        break;
       }
-
-      char *str = EXT_ARGS_CurrentPos(ipr);
-      if(*str != '\0') {
-        res = EXT_ARGS_INPUT_ERR;
-        *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Ambiguous argument \"%s\"", bk);
-        goto done;
+      int mid = l + (h - l) / 2;
+      if(__atomic_compare_exchange_n(&v->range, &r, EXT_ARGS_RANGE(l, mid), false, __ATOMIC_ACQ_REL,
+          __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&w->range, EXT_ARGS_RANGE(mid, h), __ATOMIC_RELEASE);
+        return true;
       }
-      continue;
     }
+  }
+  return false;
+}
 
-    if(EXT_ARGS_Char('=', ipr)) {
-      char *str = EXT_ARGS_CurrentPos(ipr);
-      EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_EQL, .str = str - 1}), prs.jbuf);
-      if(*str != '\0') {
-        EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_VAL, .str = str}), prs.jbuf);
+static void *EXT_ARGS_BatchWork(void *ud) {
+  EXT_ARGS_BatchWorker *w = ud;
+  EXT_ARGS_BatchPool *pool = w->pool;
+  int lo, hi;
+  while(!__atomic_load_n(&pool->failed, __ATOMIC_RELAXED)) {
+    if(!EXT_ARGS_TakeOwn(w, &lo, &hi)) {
+      if(!EXT_ARGS_Steal(w)) {
+        break;
       }
       continue;
     }
+    if(!EXT_ARGS_BatchRun(&w->scratch, pool->schema, lo, hi, pool->argcs, pool->argvs, pool->envVals, pool->out)) {
+      __atomic_store_n(&pool->failed, 1, __ATOMIC_RELAXED);
+    }
+  }
+  return NULL;
+}
 
-    if(EXT_ARGS_Char('-', ipr) && EXT_ARGS_Char('-', ipr)) {
-      EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_EOI}), prs.jbuf);
-      break;
+EXT_ARGS_API int ext_args_parse_batch_mt(const ext_args_schema *schema, const ext_args_options *opts, int n,
+    const int *argcs, char **argvs[], ext_args_batch_out *out, int threads) {
+  const ext_args_allocator *mem = opts ? opts->allocator : NULL;
+  if(threads > n) {
+    threads = n;
+  }
+  if(threads < 1) {
+    threads = 1;
+  }
+
+  char *inlEnv[EXT_ARGS_INLINE_SCHEMA];
+  char **envVals = EXT_ARGS_BatchEnv(schema, opts, inlEnv);
+  if(!envVals) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  EXT_ARGS_BatchWorker *workers = EXT_ARGS_Calloc(mem, threads, sizeof(*workers));
+  if(!workers) {
+    if(envVals != inlEnv) {
+      EXT_ARGS_Free(mem, envVals);
+    }
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  EXT_ARGS_BatchPool pool = {schema, argcs, argvs, envVals, out, workers, threads, 0};
+  for(int i = 0; i < threads; i++) {
+    EXT_ARGS_BatchWorker *w = &workers[i];
+    w->pool = &pool;
+    w->idx = i;
+    w->range = EXT_ARGS_RANGE((long long)n * i / threads, (long long)n * (i + 1) / threads);
+    if(!EXT_ARGS_BatchInit(&w->scratch, opts)) {
+      pool.failed = 1;
     }
+    w->scratch.opts.stats = NULL; // only the totals, the threads would race
+  }
 
-    EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_VAL, .str = bk}), prs.jbuf);
+  // A thread which doesn't start leaves its range to be stolen
+  for(int i = 1; i < threads && !pool.failed; i++) {
+    workers[i].isStarted = pthread_create(&workers[i].thread, NULL, EXT_ARGS_BatchWork, &workers[i]) == 0;
+  }
+  EXT_ARGS_BatchWork(&workers[0]);
+  for(int i = 1; i < threads; i++) {
+    if(workers[i].isStarted) {
+      pthread_join(workers[i].thread, NULL);
+    }
   }
 
-  if(inp->tokensCount == 0 || inp->tokens[inp->tokensCount - 1].type != EXT_ARGS_UTOK_EOI) {
-    EXT_ARGS_DYN_ARY_SAVE(inp, tokens, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UTok){.type = EXT_ARGS_UTOK_EOI}), prs.jbuf);
+  for(int i = 0; i < threads; i++) {
+    EXT_ARGS_Free(mem, workers[i].scratch.buf);
+  }
+  EXT_ARGS_Free(mem, workers);
+  if(envVals != inlEnv) {
+    EXT_ARGS_Free(mem, envVals);
   }
+  return pool.failed ? EXT_ARGS_NO_MEM_ERR : EXT_ARGS_NO_ERR;
+}
 
-  // Parsing
+#endif // EXT_ARGS_THREADS
 
-  int i = 0;
+EXT_ARGS_API void ext_args_commands_free(ext_args_commands *cmds) {
+  if(!cmds) {
+    return;
+  }
+  const ext_args_allocator *mem = cmds->mem;
+  ext_args_schema_free(cmds->global);
+  for(int i = 0; cmds->schemas && i < cmds->commandsCount; i++) {
+    ext_args_schema_free(cmds->schemas[i]);
+  }
+  EXT_ARGS_Free(mem, cmds->schemas);
+  EXT_ARGS_Free(mem, cmds->index);
+  EXT_ARGS_Free(mem, cmds);
+}
+
+// Index in `commands` or -1
+static int EXT_ARGS_FindCommand(const ext_args_commands *cmds, const char *name) {
+  unsigned slot = EXT_ARGS_Hash(name, strlen(name)) & cmds->indexMask;
   for(;;) {
-    if(inp->tokens[i].type == EXT_ARGS_UTOK_EOI) {
-      break;
+    int ci = cmds->index[slot];
+    if(ci == -1 || strcmp(cmds->commands[ci].name, name) == 0) {
+      return ci;
     }
+    slot = (slot + 1) & cmds->indexMask;
+  }
+}
 
-    if(inp->tokens[i].type == EXT_ARGS_UTOK_FLOAT) {
-      EXT_ARGS_DYN_ARY_SAVE(inp, floats, EXT_ARGS_PREALLOC, 0, ((EXT_ARGS_UFloatArg){
-        .str = inp->tokens[i].str,
-        .len = inp->tokens[i].len
-      }), prs.jbuf);
-      EXT_ARGS_UFloatArg *arg = &inp->floats[inp->floatsCount - 1];
+EXT_ARGS_API int ext_args_commands_init(char *globalFmt, const ext_args_command *table, int count,
+    const ext_args_allocator *allocator, ext_args_commands **ocmds, char **oerr) {
+  *ocmds = NULL;
+  *oerr = NULL;
 
-      i++;
+  // Allocated before setjmp, so the handler sees it
+  ext_args_commands *cmds = EXT_ARGS_Calloc(allocator, 1, sizeof(*cmds));
+  if(!cmds) {
+    return EXT_ARGS_NO_MEM_ERR;
+  }
+  if(allocator) {
+    cmds->allocator = *allocator;
+    cmds->mem = &cmds->allocator;
+  }
+  cmds->commands = table;
+  cmds->commandsCount = count;
 
-      if(inp->tokens[i].type == EXT_ARGS_UTOK_EQL) {
-        i++;
-        if(inp->tokens[i].type != EXT_ARGS_UTOK_VAL) {
-          res = EXT_ARGS_INPUT_ERR;
-          *oerr = EXT_ARGS_FmtErr(prs.jbuf, "A value expected \"%s\"", inp->tokens[i - 2].str);
-          goto done;
-        }
-        arg->assignVal = inp->tokens[i].str;
+  jmp_buf jbuf;
+  if(setjmp(jbuf) == EXT_ARGS_ERR_MEM) {
+    ext_args_commands_free(cmds);
+    *oerr = NULL;
+    return EXT_ARGS_NO_MEM_ERR;
+  }
 
-        i++;
-      }
-      continue;
-    }
+  unsigned size = 8;
+  while(size < (unsigned)count * 2) {
+    size *= 2;
+  }
+  cmds->indexMask = size - 1;
+  cmds->index = EXT_ARGS_Alloc(cmds->mem, sizeof(*cmds->index) * size);
+  cmds->schemas = EXT_ARGS_Calloc(cmds->mem, count ? count : 1, sizeof(*cmds->schemas));
+  if(!cmds->index || !cmds->schemas) {
+    longjmp(jbuf, EXT_ARGS_ERR_MEM);
+  }
+  memset(cmds->index, -1, sizeof(*cmds->index) * size);
 
-    if(inp->tokens[i].type == EXT_ARGS_UTOK_VAL) {
-      EXT_ARGS_DYN_ARY_SAVE(inp, posArgs, EXT_ARGS_PREALLOC, 0, inp->tokens[i].str, prs.jbuf);
-      i++;
-      continue;
+  for(int i = 0; i < count; i++) {
+    if(EXT_ARGS_FindCommand(cmds, table[i].name) != -1) {
+      *oerr = EXT_ARGS_FmtErr(cmds->mem, jbuf, "Command \"%s\" is defined more than once", table[i].name);
+      ext_args_commands_free(cmds);
+      return EXT_ARGS_SCHEMA_ERR;
     }
-
-    res = EXT_ARGS_INPUT_ERR;
-    *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Unexpected input \"%s\"", inp->tokens[i].str);
-    goto done;
+    unsigned slot = EXT_ARGS_Hash(table[i].name, strlen(table[i].name)) & cmds->indexMask;
+    while(cmds->index[slot] != -1) {
+      slot = (slot + 1) & cmds->indexMask;
+    }
+    cmds->index[slot] = i;
   }
 
-  if(inp->tokens[i].type != EXT_ARGS_UTOK_EOI) {
-    res = EXT_ARGS_INPUT_ERR;
-    *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Unexpected input \"%s\"", inp->tokens[i].str);
-    goto done;
+  int res = ext_args_compile_ex(globalFmt, cmds->mem, &cmds->global, oerr);
+  if(res != EXT_ARGS_NO_ERR) {
+    ext_args_commands_free(cmds);
+    return res;
   }
 
-  // Validations
+  *ocmds = cmds;
+  return res;
+}
 
-  for(int i = 0; i < inp->floatsCount; i++) {
-    EXT_ARGS_UFloatArg uf = inp->floats[i];
-    bool found = false;
+EXT_ARGS_API int ext_args_dispatch(ext_args_commands *cmds, int argc, char *argv[], int *ocmd,
+    const ext_args_schema **oschema, int *osplit, char **oerr) {
+  jmp_buf jbuf;
+  *oerr = NULL;
 
-    for(int i = 0; i < prs.floatsCount; i++) {
-      EXT_ARGS_FloatArg f = prs.floats[i];
-      if(uf.len != f.len) {
-        continue;
-      }
-      if(strncmp(uf.str, f.str, f.len) == 0) {
-        EXT_ARGS_FloatArgsGroup *gr = &prs.groups[f.groupIdx];
-        if(gr->isUsed) {
-          if(!gr->isRepeating) {
-            res = EXT_ARGS_INPUT_ERR;
-            *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Same arguments provided multiple times: %.*s", uf.len, uf.str);
-            goto done;
-          }
-        }
+  if(setjmp(jbuf) == EXT_ARGS_ERR_MEM) {
+    *oerr = NULL;
+    return EXT_ARGS_NO_MEM_ERR;
+  }
 
-        if(gr->hasAssign) {
-          if(!uf.assignVal && !gr->isAssignOptional) {
-            res = EXT_ARGS_INPUT_ERR;
-            *oerr = EXT_ARGS_FmtErr(prs.jbuf, "\"%.*s\" argument requires a value", uf.len, uf.str);
-            goto done;
-          }
-        } else { // assign not required
-          if(uf.assignVal) {
-            res = EXT_ARGS_INPUT_ERR;
-            *oerr = EXT_ARGS_FmtErr(prs.jbuf, "\"%.*s\" argument does not require a value", uf.len, uf.str);
-            goto done;
-          }
-        }
+  int split = 1;
+  while(split < argc && argv[split][0] == '-') {
+    split++;
+  }
+  if(split == argc) {
+    *oerr = EXT_ARGS_FmtErr(cmds->mem, jbuf, "A command expected");
+    return EXT_ARGS_INPUT_ERR;
+  }
 
-        gr->isUsed = true;
-        found = true;
-        break;
-      }
-    }
+  int ci = EXT_ARGS_FindCommand(cmds, argv[split]);
+  if(ci == -1) {
+    *oerr = EXT_ARGS_FmtErr(cmds->mem, jbuf, "Unknown command \"%s\"", argv[split]);
+    return EXT_ARGS_INPUT_ERR;
+  }
 
-    if(!found) {
-      res = EXT_ARGS_INPUT_ERR;
-      *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Ambiguous argument \"%.*s\" provided", uf.len, uf.str);
-      goto done;
+  if(!cmds->schemas[ci]) {
+    int res = ext_args_compile_ex(cmds->commands[ci].fmt, cmds->mem, &cmds->schemas[ci], oerr);
+    if(res != EXT_ARGS_NO_ERR) {
+      return res;
     }
   }
 
-  // Checking floats that specified but not provided
-  for(int i = 0; i < prs.groupsCount; i++) {
-    EXT_ARGS_FloatArgsGroup *gr = &prs.groups[i];
-    if(!gr->isUsed) {
-      if(!gr->isOptional) {
-        for(int j = 0; j < prs.floatsCount; j++) {
-          EXT_ARGS_FloatArg fa = prs.floats[j];
-          if(fa.groupIdx == i) {
-            res = EXT_ARGS_INPUT_ERR;
-            char *s = gr->aliasCount > 1 ? "(or alias) " : "";
-            *oerr = EXT_ARGS_FmtErr(prs.jbuf, "\"%.*s\" argument %srequired but not provided", fa.len, fa.str, s);
-            goto done;
-          }
-        }
-      }
+  *ocmd = ci;
+  *oschema = cmds->schemas[ci];
+  *osplit = split;
+  return EXT_ARGS_NO_ERR;
+}
+
+static void *EXT_ARGS_StreamVar(ext_args_stream *st, int slot) {
+  size_t off = st->bound->offsets[slot];
+  return off == EXT_ARGS_UNBOUND ? NULL : st->dst + off;
+}
+
+// Frees the group flags, the stream only answers with `res` after this
+static void EXT_ARGS_StreamClose(ext_args_stream *st, int res) {
+  if(st->groups != st->inlGroups) {
+    EXT_ARGS_Free(st->schema->mem, st->groups);
+  }
+  st->groups = NULL;
+  EXT_ARGS_Free(st->schema->mem, st->envVals);
+  st->envVals = NULL;
+  st->state = EXT_ARGS_STREAM_CLOSED;
+  st->err = res;
+}
+
+// Status of a closed stream, failures are reported again
+static int EXT_ARGS_StreamClosed(ext_args_stream *st, char **oerr) {
+  if(st->err == EXT_ARGS_INPUT_ERR) {
+    *oerr = EXT_ARGS_FmtErr(st->schema->mem, st->jbuf, "The stream has failed before");
+  }
+  return st->err;
+}
+
+EXT_ARGS_API int ext_args_stream_init(ext_args_stream *st, const ext_args_bound *bound, void *dst,
+    ext_args_emit_fn emit, void *ud) {
+  const ext_args_schema *schema = bound->schema;
+  *st = (ext_args_stream){.schema = schema, .bound = bound, .dst = dst, .emit = emit, .ud = ud};
+
+  st->groups = st->inlGroups;
+  if(schema->groupsCount > EXT_ARGS_INLINE_SCHEMA) {
+    st->groups = EXT_ARGS_Calloc(schema->mem, schema->groupsCount, sizeof(*st->groups));
+    if(!st->groups) {
+      return EXT_ARGS_NO_MEM_ERR;
     }
   }
+  return EXT_ARGS_NO_ERR;
+}
 
-  int manposArgsCount = 0;
-  for(int i = 0; i < prs.posArgsCount; i++) {
-    if(!prs.posArgs[i].isOptional) {
-      manposArgsCount += 1;
+// Assigns a checked float or passes it to `emit`
+static void EXT_ARGS_StreamTake(void *ctx, const EXT_ARGS_UFloatArg *uf) {
+  ext_args_stream *st = ctx;
+  const EXT_ARGS_FloatArgsGroup *gr = &st->schema->groups[uf->groupIdx];
+  if(gr->isRepeating) {
+    if(st->emit) {
+      st->emit(st->ud, gr->seqIdx, uf->str, uf->len, uf->assignVal);
     }
+  } else {
+    EXT_ARGS_FillFloat(gr, EXT_ARGS_StreamVar(st, uf->groupIdx), uf);
   }
+}
 
-  if(inp->posArgsCount < manposArgsCount) {
-    res = EXT_ARGS_INPUT_ERR;
-    *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Not enough positional arguments provided");
-    goto done;
+static int EXT_ARGS_StreamOne(ext_args_stream *st, EXT_ARGS_UFloatArg *uf, char **oerr) {
+  const ext_args_schema *schema = st->schema;
+  int res = EXT_ARGS_CheckFloat(schema, st->groups, schema->mem, st->jbuf, false, st->abbrev, uf, oerr);
+  if(res != EXT_ARGS_NO_ERR) {
+    return res;
   }
+  st->groups[uf->groupIdx].isUsed = true;
+  EXT_ARGS_StreamTake(st, uf);
+  return EXT_ARGS_NO_ERR;
+}
 
-  if(!prs.varPosArgsEnabled) {
-    if(inp->posArgsCount > prs.posArgsCount) {
-      res = EXT_ARGS_INPUT_ERR;
-      *oerr = EXT_ARGS_FmtErr(prs.jbuf, "Too many positional arguments provided");
-      goto done;
+// Completes the pending float, a cluster is checked letter by letter
+static int EXT_ARGS_StreamFloat(ext_args_stream *st, char **oerr) {
+  const ext_args_schema *schema = st->schema;
+  EXT_ARGS_UFloatArg *uf = &st->pending;
+  st->state = EXT_ARGS_STREAM_ANY;
+
+  int n = st->cluster ? EXT_ARGS_ClusterLen(schema, uf->str, uf->len) : 0;
+  for(int k = 1; k <= n; k++) {
+    EXT_ARGS_FloatArg f = schema->floats[schema->shortIndex[(unsigned char)uf->str[k]]];
+    EXT_ARGS_UFloatArg letter = {.str = f.str, .len = f.len, .assignVal = k == n ? uf->assignVal : NULL};
+    int res = EXT_ARGS_StreamOne(st, &letter, oerr);
+    if(res != EXT_ARGS_NO_ERR) {
+      return res;
     }
   }
+  return n ? EXT_ARGS_NO_ERR : EXT_ARGS_StreamOne(st, uf, oerr);
+}
 
-  // Get pointers to user passed vars
+static int EXT_ARGS_StreamPos(ext_args_stream *st, char *val, char **oerr) {
+  const ext_args_schema *schema = st->schema;
+  int i = st->posArgsCount++;
 
-  for(int i = 0; i < prs.sequenceCount; i++) {
-    EXT_ARGS_SequenceElement sq = prs.sequence[i];
-    void *p = va_arg(ap, void *);
-    if(sq.type == EXT_ARGS_ARG_POS) {
-      prs.posArgs[sq.idx].varPtr = p;
-    } else {
-      prs.groups[sq.idx].varPtr = p;
+  if(i < schema->posArgsCount) {
+    char **p = EXT_ARGS_StreamVar(st, schema->groupsCount + i);
+    if(p) {
+      *p = val;
+    }
+  } else if(schema->varPosArgsEnabled) {
+    if(st->emit) {
+      st->emit(st->ud, schema->sequenceCount, NULL, 0, val);
     }
+  } else {
+    *oerr = EXT_ARGS_FmtErr(schema->mem, st->jbuf, "Too many positional arguments provided");
+    return EXT_ARGS_INPUT_ERR;
   }
-  if(prs.varPosArgsEnabled) {
-    prs.varPosrArgsVarPtr = va_arg(ap, void *);
+  return EXT_ARGS_NO_ERR;
+}
+
+static int EXT_ARGS_StreamTok(ext_args_stream *st, EXT_ARGS_UTok tok, char **oerr) {
+  int res;
+
+  if(st->state == EXT_ARGS_STREAM_EQL) {
+    if(tok.type != EXT_ARGS_UTOK_VAL) {
+      *oerr = EXT_ARGS_FmtErr(st->schema->mem, st->jbuf, "A value expected \"%s\"", st->pending.str);
+      return EXT_ARGS_INPUT_ERR;
+    }
+    st->pending.assignVal = tok.str;
+    return EXT_ARGS_StreamFloat(st, oerr);
   }
 
-  // Vars filling, assings
+  if(st->state == EXT_ARGS_STREAM_FLOAT) {
+    if(tok.type == EXT_ARGS_UTOK_EQL) {
+      st->state = EXT_ARGS_STREAM_EQL;
+      return EXT_ARGS_NO_ERR;
+    }
+    if((res = EXT_ARGS_StreamFloat(st, oerr)) != EXT_ARGS_NO_ERR) {
+      return res;
+    }
+  }
 
-  for(int i = 0; i < inp->floatsCount; i++) {
-    EXT_ARGS_UFloatArg uf = inp->floats[i];
+  switch(tok.type) {
+    case EXT_ARGS_UTOK_FLOAT:
+      st->pending = (EXT_ARGS_UFloatArg){.str = tok.str, .len = tok.len};
+      st->state = EXT_ARGS_STREAM_FLOAT;
+      return EXT_ARGS_NO_ERR;
 
-    for(int i = 0; i < prs.floatsCount; i++) {
-      EXT_ARGS_FloatArg f = prs.floats[i];
-      if(uf.len != f.len) {
-        continue;
-      }
-      if(strncmp(uf.str, f.str, f.len) == 0) {
-        EXT_ARGS_FloatArgsGroup *gr = &prs.groups[f.groupIdx];
+    case EXT_ARGS_UTOK_VAL:
+      return EXT_ARGS_StreamPos(st, tok.str, oerr);
 
-        if(gr->isRepeating) {
-          // for repeating assign always exists
-          EXT_ARGS_DYN_ARY_SAVE(gr, ary, EXT_ARGS_PREALLOC, 1, uf.assignVal, prs.jbuf);
-          gr->ary[gr->aryCount] = NULL;
-          if(gr->varPtr) {
-            *((char ***)gr->varPtr) = gr->ary;
-          }
+    case EXT_ARGS_UTOK_EOI:
+      st->state = EXT_ARGS_STREAM_END;
+      return EXT_ARGS_NO_ERR;
+  }
 
-        } else {
-          if(gr->hasAssign) {
-            if(uf.assignVal) {
-              if(gr->varPtr) {
-                *((char **)gr->varPtr) = uf.assignVal;
-              }
-            } else { // no value provided by user but the flag is set
-              if(gr->varPtr) {
-                *((char **)gr->varPtr) = ext_args_no_value;
-              }
-            }
-          } else { // assign not required
-            if(gr->varPtr) {
-              *((bool *)gr->varPtr) = true;
-            }
-          }
-        }
+  *oerr = EXT_ARGS_FmtErr(st->schema->mem, st->jbuf, "Unexpected input \"%s\"", tok.str);
+  return EXT_ARGS_INPUT_ERR;
+}
 
-        break;
-      }
-    }
+static int EXT_ARGS_StreamArg(ext_args_stream *st, char *arg, char **oerr) {
+  EXT_ARGS_UTok toks[3];
+  int n = EXT_ARGS_LexArg(arg, toks);
+  if(n == -1) {
+    *oerr = EXT_ARGS_FmtErr(st->schema->mem, st->jbuf, "Ambiguous argument \"%s\"", arg);
+    return EXT_ARGS_INPUT_ERR;
+  }
+  int res = EXT_ARGS_NO_ERR;
+  for(int i = 0; i < n && res == EXT_ARGS_NO_ERR; i++) {
+    res = EXT_ARGS_StreamTok(st, toks[i], oerr);
   }
+  return res;
+}
 
-  // filling floats that specified but not provided
-  for(int i = 0; i < prs.groupsCount; i++) {
-    EXT_ARGS_FloatArgsGroup *gr = &prs.groups[i];
-    if(!gr->isUsed) {
-      if(gr->isOptional) {
-        if(gr->isRepeating) {
-          EXT_ARGS_DYN_ARY_SAVE(gr, ary, 1, 0, NULL, prs.jbuf);
-          if(gr->varPtr) {
-            *((char ***)gr->varPtr) = gr->ary;
-          }
-        } else {
-          if(gr->varPtr) {
-            if(gr->hasAssign) {
-              *((char **)gr->varPtr) = NULL;
-            } else {
-              *((bool *)gr->varPtr) = false;
-            }
-          }
-        }
-      }
-    }
+EXT_ARGS_API int ext_args_feed(ext_args_stream *st, char *arg, char **oerr) {
+  *oerr = NULL;
+
+  if(setjmp(st->jbuf) == EXT_ARGS_ERR_MEM) {
+    EXT_ARGS_StreamClose(st, EXT_ARGS_NO_MEM_ERR);
+    *oerr = NULL;
+    return EXT_ARGS_NO_MEM_ERR;
   }
 
-  // NULLing optionals not provided by user
-  for(int i = inp->posArgsCount; i < prs.posArgsCount; i++) {
-    char *p = prs.posArgs[i].varPtr;
-    if(p) {
-      *((char **)p) = NULL;
+  if(st->state == EXT_ARGS_STREAM_CLOSED) {
+    if(st->err == EXT_ARGS_NO_ERR) {
+      *oerr = EXT_ARGS_FmtErr(st->schema->mem, st->jbuf, "The stream is finished");
+      return EXT_ARGS_INPUT_ERR;
     }
+    return EXT_ARGS_StreamClosed(st, oerr);
+  }
+  if(st->state == EXT_ARGS_STREAM_END) {
+    return EXT_ARGS_NO_ERR;
   }
 
-  { // filling posArgs vars
-    EXT_ARGS_Ary *optsVarAry = &(EXT_ARGS_Ary){0};
+  int res = EXT_ARGS_StreamArg(st, arg, oerr);
+  if(res != EXT_ARGS_NO_ERR) {
+    EXT_ARGS_StreamClose(st, res);
+  }
+  return res;
+}
 
-    for(int i = 0; i < inp->posArgsCount; i++) {
-      if(i < prs.posArgsCount) {
-        void *p = prs.posArgs[i].varPtr;
-        if(p) {
-          *((char **)p) = inp->posArgs[i];
-        }
-      } else {
-        // Filling opts
+EXT_ARGS_API int ext_args_finish(ext_args_stream *st, char **oerr) {
+  const ext_args_schema *schema = st->schema;
+  int res = EXT_ARGS_NO_ERR;
+  *oerr = NULL;
 
-        if(!prs.varPosrArgsVarPtr) {
-          // No need to create an array and assign anything
-          break;
-        }
+  if(setjmp(st->jbuf) == EXT_ARGS_ERR_MEM) {
+    EXT_ARGS_StreamClose(st, EXT_ARGS_NO_MEM_ERR);
+    *oerr = NULL;
+    return EXT_ARGS_NO_MEM_ERR;
+  }
 
-        EXT_ARGS_DYN_ARY_SAVE(optsVarAry, ary, EXT_ARGS_PREALLOC, 1, inp->posArgs[i], prs.jbuf);
-        optsVarAry->ary[optsVarAry->aryCount] = NULL;
-        if(prs.varPosrArgsVarPtr) {
-          *((char ***)prs.varPosrArgsVarPtr) = optsVarAry->ary;
-        }
-      }
+  if(st->state == EXT_ARGS_STREAM_CLOSED) {
+    return EXT_ARGS_StreamClosed(st, oerr);
+  }
+
+  if(st->state == EXT_ARGS_STREAM_FLOAT) {
+    if((res = EXT_ARGS_StreamFloat(st, oerr)) != EXT_ARGS_NO_ERR) {
+      goto done;
     }
+  } else if(st->state == EXT_ARGS_STREAM_EQL) {
+    res = EXT_ARGS_INPUT_ERR;
+    *oerr = EXT_ARGS_FmtErr(schema->mem, st->jbuf, "A value expected \"%s\"", st->pending.str);
+    goto done;
+  }
 
-    // Filling optional Pos args for which values not provided by user,
-    // like c and d in this schema: a b [c] [d]
-    for(int i = inp->posArgsCount; i < prs.posArgsCount; i++) {
-      void *p = prs.posArgs[i].varPtr;
-      if(p) {
-        *((char **)p) = NULL;
-      }
+  // The same order as in the one shot parse
+  char *inlEnv[EXT_ARGS_INLINE_SCHEMA];
+  char **envVals = inlEnv;
+  if(schema->groupsCount > EXT_ARGS_INLINE_SCHEMA) {
+    envVals = st->envVals = EXT_ARGS_Alloc(schema->mem, sizeof(*envVals) * schema->groupsCount);
+  }
+  if(!envVals || !EXT_ARGS_LookupEnv(schema, st->envp ? st->envp : EXT_ARGS_ENVIRON, schema->mem, envVals)) {
+    longjmp(st->jbuf, EXT_ARGS_ERR_MEM);
+  }
+  res = EXT_ARGS_ResolveEnv(schema, st->groups, schema->mem, st->jbuf, false, envVals, EXT_ARGS_StreamTake, st,
+      oerr);
+  if(res != EXT_ARGS_NO_ERR) {
+    goto done;
+  }
+  if(st->config) {
+    res = EXT_ARGS_ResolveConfig(schema, st->groups, schema->mem, st->jbuf, false, st->config, EXT_ARGS_StreamTake,
+        st, oerr);
+    if(res != EXT_ARGS_NO_ERR) {
+      goto done;
     }
+  }
 
-    // No external pos args provided, let's return an empty array
-    if(prs.varPosArgsEnabled && !optsVarAry->ary) {
-      if(prs.varPosrArgsVarPtr) {
-        char ***p = prs.varPosrArgsVarPtr;
-        *p = calloc(1, sizeof(*p));
-        if(!(*p)) {
-          longjmp(prs.jbuf, EXT_ARGS_ERR_MEM);
-        }
-        **p = NULL;
-      }
+  res = EXT_ARGS_CheckMissing(schema, st->groups, st->posArgsCount, schema->mem, st->jbuf, false, oerr);
+  if(res != EXT_ARGS_NO_ERR) {
+    goto done;
+  }
+
+  for(int i = 0; i < schema->groupsCount; i++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[i];
+    if(!st->groups[i].isUsed && gr->isOptional && !gr->isRepeating) {
+      EXT_ARGS_FillDefault(gr, EXT_ARGS_StreamVar(st, i));
+    }
+  }
+  for(int i = st->posArgsCount; i < schema->posArgsCount; i++) {
+    char **p = EXT_ARGS_StreamVar(st, schema->groupsCount + i);
+    if(p) {
+      *p = NULL;
     }
   }
 
 done:
-  free(prs.posArgs);
-  free(prs.groups);
-  free(prs.floats);
-  free(prs.sequence);
+  EXT_ARGS_StreamClose(st, res);
+  return res;
+}
+
+EXT_ARGS_API int ext_args(int argc, char *argv[], char *fmt, va_list ap, char **oerr) {
+  // One time schema. It stays in the parser's inline storage as long as it
+  // fits and small schemas are matched without the aliases index
+  EXT_ARGS_ParserInline storage;
+  EXT_ARGS_Parser *prs = &(EXT_ARGS_Parser){.str = fmt};
+  EXT_ARGS_ParserUseInline(prs, &storage);
+  ext_args_schema *schema = &(ext_args_schema){0};
+  *oerr = NULL;
+
+  int res = EXT_ARGS_Compile(prs, schema, oerr);
+  if(res == EXT_ARGS_NO_ERR && schema->floatsCount > EXT_ARGS_INLINE_SCHEMA) {
+    schema->aliasIndex = EXT_ARGS_BuildAliasIndex(NULL, schema->floats, schema->floatsCount, &schema->aliasIndexMask);
+    if(!schema->aliasIndex) {
+      res = EXT_ARGS_NO_MEM_ERR;
+    }
+  }
 
-  free(inp->tokens);
-  free(inp->floats);
-  free(inp->posArgs);
+  if(res == EXT_ARGS_NO_ERR) {
+    res = ext_args_parse(schema, argc, argv, ap, oerr);
+  }
 
+  EXT_ARGS_Free(NULL, (void *)schema->aliasIndex);
+  EXT_ARGS_ParserFree(prs);
   return res;
 }
 
-#endif // INCLUDE_EXT_ARGS_H
+#endif // EXT_ARGS_IMPLEMENTATION
 
 /*
 ------------------------------------------------------------------------------
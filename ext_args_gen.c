@@ -0,0 +1,715 @@
+// Schema compiler. Parses a schema with the ext_args grammar and writes a C
+// header for it alone:
+//
+//   <name>_args   - struct with a typed field per argument
+//   <name>_schema - the schema tables as static const data, nothing is
+//                   lexed or allocated at runtime
+//   <name>_match  - aliases matcher, a switch on the length and then on the
+//                   most distinctive character, gperf style
+//   <name>_parse  - parser written for the schema: a switch on the matched
+//                   alias converts the value straight into its typed field,
+//                   a bitmask checks the required options. Response files,
+//                   config files, emit and stats go to ext_args_parse_into
+//
+// Usage: ext_args_gen [-o|--output=path] name schema
+//
+// The header is included after ext_args.h
+#define EXT_ARGS_IMPLEMENTATION
+#include "ext_args.h"
+
+static const char *keywords[] = {
+  "auto", "bool", "break", "case", "char", "const", "continue", "default", "do", "double", "else", "enum",
+  "extern", "false", "float", "for", "goto", "if", "inline", "int", "long", "register", "restrict",
+  "return", "short", "signed", "sizeof", "static", "struct", "switch", "true", "typedef", "union",
+  "unsigned", "void", "volatile", "while"
+};
+
+// Field names, indexed as the bound offsets: groups, positional, variadic
+static char (*fields)[64];
+static int fieldsCount;
+
+// C identifier from a schema name or alias: leading dashes are dropped,
+// the other dashes become '_'. Keywords and duplicates get a suffix
+static void add_field(const char *str, int len) {
+  char *f = fields[fieldsCount];
+  while(len > 0 && *str == '-') {
+    str++;
+    len--;
+  }
+  if(len > 50) {
+    len = 50;
+  }
+  for(int i = 0; i < len; i++) {
+    f[i] = str[i] == '-' ? '_' : str[i];
+  }
+  f[len] = '\0';
+
+  bool taken = false;
+  for(int i = 0; i < (int)(sizeof(keywords) / sizeof(*keywords)); i++) {
+    taken = taken || !strcmp(f, keywords[i]);
+  }
+  for(int i = 0; i < fieldsCount; i++) {
+    taken = taken || !strcmp(f, fields[i]);
+  }
+  if(taken) {
+    sprintf(f + len, "_%d", fieldsCount);
+  }
+  fieldsCount++;
+}
+
+static const char *group_type(const EXT_ARGS_FloatArgsGroup *gr) {
+  if(gr->isRepeating) {
+    return "char **";
+  }
+  if(!gr->hasAssign) {
+    return "bool ";
+  }
+  switch(gr->valType) {
+    case EXT_ARGS_T_INT: return "long long ";
+    case EXT_ARGS_T_UINT: return "unsigned long long ";
+    case EXT_ARGS_T_F64:
+    case EXT_ARGS_T_DURATION: return "double ";
+    case EXT_ARGS_T_SIZE: return "size_t ";
+    case EXT_ARGS_T_BOOL: return "bool ";
+  }
+  return "char *";
+}
+
+static const char *type_names[] = {
+  "EXT_ARGS_T_STR", "EXT_ARGS_T_INT", "EXT_ARGS_T_UINT", "EXT_ARGS_T_F64", "EXT_ARGS_T_SIZE",
+  "EXT_ARGS_T_DURATION", "EXT_ARGS_T_BOOL"
+};
+
+static const char *bool_str(bool b) {
+  return b ? "true" : "false";
+}
+
+// Position where the aliases of length `len` differ the most
+static int best_position(const ext_args_schema *schema, int len) {
+  int best = 0, bestCount = 0;
+  for(int p = 0; p < len; p++) {
+    bool seen[256] = {false};
+    int count = 0;
+    for(int i = 0; i < schema->floatsCount; i++) {
+      const EXT_ARGS_FloatArg *f = &schema->floats[i];
+      if(f->len == len && !seen[(unsigned char)f->str[p]]) {
+        seen[(unsigned char)f->str[p]] = true;
+        count++;
+      }
+    }
+    if(count > bestCount) {
+      best = p;
+      bestCount = count;
+    }
+  }
+  return best;
+}
+
+static void write_match(FILE *out, const char *name, const ext_args_schema *schema) {
+  fprintf(out, "static int %s_match(const char *s, int len) {\n", name);
+  fprintf(out, "  switch(len) {\n");
+
+  int maxLen = 0;
+  for(int i = 0; i < schema->floatsCount; i++) {
+    maxLen = schema->floats[i].len > maxLen ? schema->floats[i].len : maxLen;
+  }
+  for(int len = 1; len <= maxLen; len++) {
+    int count = 0;
+    for(int i = 0; i < schema->floatsCount; i++) {
+      count += schema->floats[i].len == len;
+    }
+    if(!count) {
+      continue;
+    }
+
+    fprintf(out, "    case %d:\n", len);
+    if(count == 1) {
+      for(int i = 0; i < schema->floatsCount; i++) {
+        const EXT_ARGS_FloatArg *f = &schema->floats[i];
+        if(f->len == len) {
+          fprintf(out, "      return memcmp(s, \"%.*s\", %d) ? -1 : %d;\n", len, f->str, len, i);
+        }
+      }
+      continue;
+    }
+
+    int p = best_position(schema, len);
+    fprintf(out, "      switch(s[%d]) {\n", p);
+    bool done[256] = {false};
+    for(int i = 0; i < schema->floatsCount; i++) {
+      const EXT_ARGS_FloatArg *f = &schema->floats[i];
+      unsigned char c = f->str[p];
+      if(f->len != len || done[c]) {
+        continue;
+      }
+      done[c] = true;
+      fprintf(out, "        case '%c':\n", c);
+      for(int j = i; j < schema->floatsCount; j++) {
+        const EXT_ARGS_FloatArg *g = &schema->floats[j];
+        if(g->len == len && (unsigned char)g->str[p] == c) {
+          fprintf(out, "          if(!memcmp(s, \"%.*s\", %d)) {\n", len, g->str, len);
+          fprintf(out, "            return %d;\n", j);
+          fprintf(out, "          }\n");
+        }
+      }
+      fprintf(out, "          break;\n");
+    }
+    fprintf(out, "      }\n");
+    fprintf(out, "      break;\n");
+  }
+  fprintf(out, "  }\n");
+  fprintf(out, "  return -1;\n");
+  fprintf(out, "}\n\n");
+}
+
+static void write_tables(FILE *out, const char *name, const ext_args_schema *schema) {
+  if(schema->posArgsCount) {
+    fprintf(out, "static const EXT_ARGS_PosArg %s_posArgs[] = {\n", name);
+    for(int i = 0; i < schema->posArgsCount; i++) {
+      const EXT_ARGS_PosArg *a = &schema->posArgs[i];
+      fprintf(out, "  {%s, \"%.*s\", %d},\n", bool_str(a->isOptional), a->len, a->str, a->len);
+    }
+    fprintf(out, "};\n\n");
+  }
+
+  if(schema->groupsCount) {
+    fprintf(out, "static const EXT_ARGS_FloatArgsGroup %s_groups[] = {\n", name);
+    for(int i = 0; i < schema->groupsCount; i++) {
+      const EXT_ARGS_FloatArgsGroup *g = &schema->groups[i];
+      fprintf(out, "  {%s, %s, %s, %s, %d, %s, %d, ", bool_str(g->isOptional), bool_str(g->hasAssign),
+              bool_str(g->isAssignOptional), bool_str(g->isRepeating), g->aliasCount, type_names[g->valType],
+              g->seqIdx);
+      if(g->envLen) {
+        fprintf(out, "\"%.*s\", %d},\n", g->envLen, g->env, g->envLen);
+      } else {
+        fprintf(out, "NULL, 0},\n");
+      }
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const EXT_ARGS_FloatArg %s_floats[] = {\n", name);
+    for(int i = 0; i < schema->floatsCount; i++) {
+      const EXT_ARGS_FloatArg *f = &schema->floats[i];
+      fprintf(out, "  {\"%.*s\", %d, %d},\n", f->len, f->str, f->len, f->groupIdx);
+    }
+    fprintf(out, "};\n\n");
+  }
+
+  fprintf(out, "static const EXT_ARGS_SequenceElement %s_sequence[] = {\n", name);
+  for(int i = 0; i < schema->sequenceCount; i++) {
+    const EXT_ARGS_SequenceElement *e = &schema->sequence[i];
+    fprintf(out, "  {%s, %d},\n", e->type == EXT_ARGS_ARG_POS ? "EXT_ARGS_ARG_POS" : "EXT_ARGS_ARG_GROUP", e->idx);
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out, "static const ext_args_schema %s_schema = {\n", name);
+  if(schema->posArgsCount) {
+    fprintf(out, "  .posArgs = %s_posArgs,\n", name);
+    fprintf(out, "  .posArgsCount = %d,\n", schema->posArgsCount);
+  }
+  if(schema->groupsCount) {
+    fprintf(out, "  .groups = %s_groups,\n", name);
+    fprintf(out, "  .groupsCount = %d,\n", schema->groupsCount);
+    fprintf(out, "  .floats = %s_floats,\n", name);
+    fprintf(out, "  .floatsCount = %d,\n", schema->floatsCount);
+    fprintf(out, "  .match = %s_match,\n", name);
+  }
+  fprintf(out, "  .sequence = %s_sequence,\n", name);
+  fprintf(out, "  .sequenceCount = %d,\n", schema->sequenceCount);
+  fprintf(out, "  .varPosArgsEnabled = %s\n", bool_str(schema->varPosArgsEnabled));
+  fprintf(out, "};\n\n");
+}
+
+static const char *conv_names[] = {
+  NULL, "ext_args_conv_int", "ext_args_conv_uint", "ext_args_conv_f64", "ext_args_conv_size",
+  "ext_args_conv_duration", "ext_args_conv_bool"
+};
+
+// Group bit in the `used` words of the parser
+static void write_bit(FILE *out, int gi) {
+  fprintf(out, "0x%llxull", 1ULL << (gi % 64));
+}
+
+static void write_helpers(FILE *out, const char *name, bool hasArrays, bool hasEnv) {
+  fprintf(out, "// Length of the alias at the start of `s`: dashes, a letter, name\n"
+               "// characters not ending with a dash. 0 when there is none\n");
+  fprintf(out, "static int %s_float_len(const char *s) {\n", name);
+  fprintf(out, "  int i = 0;\n");
+  fprintf(out, "  while(s[i] == '-') {\n");
+  fprintf(out, "    i++;\n");
+  fprintf(out, "  }\n");
+  fprintf(out, "  if(!i || (s[i] | 0x20) < 'a' || (s[i] | 0x20) > 'z') {\n");
+  fprintf(out, "    return 0;\n");
+  fprintf(out, "  }\n");
+  fprintf(out, "  for(i++; ((s[i] | 0x20) >= 'a' && (s[i] | 0x20) <= 'z') || (s[i] >= '0' && s[i] <= '9') ||\n"
+               "      s[i] == '_' || s[i] == '-'; i++) {}\n");
+  fprintf(out, "  return s[i - 1] == '-' ? 0 : i;\n");
+  fprintf(out, "}\n\n");
+
+  fprintf(out, "static void *%s_alloc(const ext_args_allocator *mem, size_t size) {\n", name);
+  fprintf(out, "  return mem ? mem->alloc(mem->ud, size) : malloc(size);\n");
+  fprintf(out, "}\n\n");
+
+  if(hasArrays) {
+    fprintf(out, "static void %s_free(const ext_args_allocator *mem, void *ptr) {\n", name);
+    fprintf(out, "  if(!mem) {\n");
+    fprintf(out, "    free(ptr);\n");
+    fprintf(out, "  } else if(mem->free && ptr) {\n");
+    fprintf(out, "    mem->free(mem->ud, ptr);\n");
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n\n");
+  }
+
+  fprintf(out, "static int %s_fail(const ext_args_allocator *mem, char **oerr, const char *fmt, ...) {\n", name);
+  fprintf(out, "  va_list ap;\n");
+  fprintf(out, "  va_start(ap, fmt);\n");
+  fprintf(out, "  int len = vsnprintf(NULL, 0, fmt, ap);\n");
+  fprintf(out, "  va_end(ap);\n\n");
+  fprintf(out, "  *oerr = %s_alloc(mem, len + 1);\n", name);
+  fprintf(out, "  if(!*oerr) {\n");
+  fprintf(out, "    return EXT_ARGS_NO_MEM_ERR;\n");
+  fprintf(out, "  }\n");
+  fprintf(out, "  va_start(ap, fmt);\n");
+  fprintf(out, "  vsnprintf(*oerr, len + 1, fmt, ap);\n");
+  fprintf(out, "  va_end(ap);\n");
+  fprintf(out, "  return EXT_ARGS_INPUT_ERR;\n");
+  fprintf(out, "}\n\n");
+
+  if(hasEnv) {
+    fprintf(out, "// Value of the variable `name`, NULL when it's unset or empty. The first\n"
+                 "// one in `envp` wins, getenv is used without it\n");
+    fprintf(out, "static char *%s_env(char **envp, const char *name, int len) {\n", name);
+    fprintf(out, "  if(!envp) {\n");
+    fprintf(out, "    char *v = getenv(name);\n");
+    fprintf(out, "    return v && *v ? v : NULL;\n");
+    fprintf(out, "  }\n");
+    fprintf(out, "  for(; *envp; envp++) {\n");
+    fprintf(out, "    if(!strncmp(*envp, name, len) && (*envp)[len] == '=' && (*envp)[len + 1]) {\n");
+    fprintf(out, "      return *envp + len + 1;\n");
+    fprintf(out, "    }\n");
+    fprintf(out, "  }\n");
+    fprintf(out, "  return NULL;\n");
+    fprintf(out, "}\n\n");
+  }
+}
+
+static void write_conv(FILE *out, const char *ind, int type, const char *var) {
+  fprintf(out, "%sswitch(%s(val, %s)) {\n", ind, conv_names[type], var);
+  fprintf(out, "%s  case EXT_ARGS_CONV_INVALID:\n", ind);
+  fprintf(out, "%s    goto invalid;\n", ind);
+  fprintf(out, "%s  case EXT_ARGS_CONV_RANGE:\n", ind);
+  fprintf(out, "%s    goto range;\n", ind);
+  fprintf(out, "%s}\n", ind);
+}
+
+// Typed fill of group `gi` from `val`, which is set unless the value is
+// optional. Array `ai` of `counts` holds the values of a repeating group
+static void write_take(FILE *out, const char *name, const char *ind, const ext_args_schema *schema, int gi,
+    int ai) {
+  const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[gi];
+  const char *f = fields[gi];
+  char var[80];
+  if(gr->isRepeating) { // always a string value
+    fprintf(out, "%sif(!a.%s && !(a.%s = %s_alloc(mem, sizeof(char *) * (end + 1)))) {\n", ind, f, f, name);
+    fprintf(out, "%s  goto noMem;\n", ind);
+    fprintf(out, "%s}\n", ind);
+    fprintf(out, "%sa.%s[counts[%d]++] = val;\n", ind, f, ai);
+  } else if(!gr->hasAssign) {
+    fprintf(out, "%sa.%s = true;\n", ind, f);
+  } else if(gr->valType == EXT_ARGS_T_STR) {
+    if(gr->isAssignOptional) {
+      fprintf(out, "%sa.%s = val ? val : ext_args_no_value;\n", ind, f);
+    } else {
+      fprintf(out, "%sa.%s = val;\n", ind, f);
+    }
+  } else {
+    snprintf(var, sizeof(var), "&a.%s", f);
+    if(gr->isAssignOptional) { // set without a value keeps the default
+      char in[32];
+      snprintf(in, sizeof(in), "%s  ", ind);
+      fprintf(out, "%sif(val) {\n", ind);
+      write_conv(out, in, gr->valType, var);
+      fprintf(out, "%s}\n", ind);
+    } else {
+      write_conv(out, ind, gr->valType, var);
+    }
+  }
+  fprintf(out, "%sused[%d] |= ", ind, gi / 64);
+  write_bit(out, gi);
+  fprintf(out, ";\n");
+}
+static void write_parse(FILE *out, const char *name, const ext_args_schema *schema) {
+  int groupsCount = schema->groupsCount, posCount = schema->posArgsCount;
+  int words = (groupsCount + 63) / 64;
+  int arrays = 0, mandatoryPos = 0;
+  bool hasEnv = false, twice = false, noValue = false, needless = false, typed = false;
+  for(int i = 0; i < groupsCount; i++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[i];
+    arrays += gr->isRepeating;
+    hasEnv = hasEnv || gr->envLen;
+    twice = twice || !gr->isRepeating;
+    noValue = noValue || (gr->hasAssign && !gr->isAssignOptional);
+    needless = needless || !gr->hasAssign;
+    typed = typed || gr->valType != EXT_ARGS_T_STR;
+  }
+  int restIdx = arrays;
+  arrays += schema->varPosArgsEnabled;
+  for(int i = 0; i < posCount; i++) {
+    mandatoryPos += !schema->posArgs[i].isOptional;
+  }
+
+  write_helpers(out, name, arrays, hasEnv);
+
+  fprintf(out, "static int %s_parse(const ext_args_options *opts, int argc, char *argv[], %s_args *dst,\n"
+               "    char **oerr) {\n", name, name);
+  fprintf(out, "  // Reading files and counting are left to the runtime\n");
+  fprintf(out, "  if(opts && (opts->responseFiles || opts->config || opts->emit || opts->stats)) {\n");
+  fprintf(out, "    return ext_args_parse_into(&%s_bound, opts, argc, argv, dst, oerr);\n", name);
+  fprintf(out, "  }\n\n");
+
+  fprintf(out, "  ext_args_allocator arenaMem;\n");
+  fprintf(out, "  const ext_args_allocator *mem = opts ? opts->allocator : NULL;\n");
+  fprintf(out, "  if(opts && opts->arena) {\n");
+  fprintf(out, "    arenaMem = ext_args_arena_allocator(opts->arena);\n");
+  fprintf(out, "    mem = &arenaMem;\n");
+  fprintf(out, "  }\n");
+  fprintf(out, "  *oerr = NULL;\n\n");
+
+  // The same errors as the runtime's, in its order: malformed arguments,
+  // misplaced values, then the arguments one by one
+  fprintf(out, "  int end = argc, misplaced = 0;\n");
+  fprintf(out, "  for(int i = 1; i < argc; i++) {\n");
+  fprintf(out, "    char *arg = argv[i];\n");
+  fprintf(out, "    int len = %s_float_len(arg);\n", name);
+  fprintf(out, "    if(len && arg[len] != '=' && arg[len] != '\\0') {\n");
+  fprintf(out, "      return %s_fail(mem, oerr, \"Ambiguous argument \\\"%%s\\\"\", arg);\n", name);
+  fprintf(out, "    }\n");
+  fprintf(out, "    if(!len && arg[0] == '-' && arg[1] == '-') {\n");
+  fprintf(out, "      end = i;\n");
+  fprintf(out, "      break;\n");
+  fprintf(out, "    }\n");
+  fprintf(out, "    if(!misplaced && (len ? arg[len] == '=' && arg[len + 1] == '\\0' : arg[0] == '=')) {\n");
+  fprintf(out, "      misplaced = i;\n");
+  fprintf(out, "    }\n");
+  fprintf(out, "  }\n");
+  fprintf(out, "  if(misplaced) {\n");
+  fprintf(out, "    return %s_fail(mem, oerr, argv[misplaced][0] == '=' ? \"Unexpected input \\\"%%s\\\"\" :\n"
+               "        \"A value expected \\\"%%s\\\"\", argv[misplaced]);\n", name);
+  fprintf(out, "  }\n\n");
+
+  // Optional fields not given are reset, typed ones keep their defaults
+  fprintf(out, "  %s_args a = *dst;\n", name);
+  for(int i = 0; i < groupsCount; i++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[i];
+    if(gr->isRepeating || (gr->isOptional && gr->valType == EXT_ARGS_T_STR)) {
+      fprintf(out, "  a.%s = %s;\n", fields[i], gr->hasAssign ? "NULL" : "false");
+    }
+  }
+  for(int i = 0; i < posCount; i++) {
+    fprintf(out, "  a.%s = NULL;\n", fields[groupsCount + i]);
+  }
+  if(schema->varPosArgsEnabled) {
+    fprintf(out, "  a.%s = NULL;\n", fields[fieldsCount - 1]);
+  }
+  if(groupsCount) {
+    fprintf(out, "  uint64_t used[%d] = {0};\n", words);
+  }
+  if(arrays) {
+    fprintf(out, "  int counts[%d] = {0};\n", arrays);
+  }
+  fprintf(out, "  int res = EXT_ARGS_NO_ERR, pos = 0;\n");
+  if(groupsCount) {
+    fprintf(out, "  const char *arg = NULL;\n");
+    fprintf(out, "  char *val = NULL;\n");
+    fprintf(out, "  int len = 0;\n");
+  }
+  fprintf(out, "\n");
+
+  fprintf(out, "  for(int i = 1; i < end; i++) {\n");
+  fprintf(out, "    %sarg = argv[i];\n", groupsCount ? "" : "char *");
+  fprintf(out, "    %slen = %s_float_len(arg);\n", groupsCount ? "" : "int ", name);
+  fprintf(out, "    if(!len) {\n");
+  if(posCount) {
+    fprintf(out, "      switch(pos++) {\n");
+    for(int i = 0; i < posCount; i++) {
+      fprintf(out, "        case %d:\n", i);
+      fprintf(out, "          a.%s = argv[i];\n", fields[groupsCount + i]);
+      fprintf(out, "          break;\n");
+    }
+    if(schema->varPosArgsEnabled) {
+      fprintf(out, "        default:\n");
+    }
+  } else {
+    fprintf(out, "      pos++;\n");
+  }
+  if(schema->varPosArgsEnabled) {
+    const char *ind = posCount ? "          " : "      ";
+    const char *rest = fields[fieldsCount - 1];
+    fprintf(out, "%sif(!a.%s && !(a.%s = %s_alloc(mem, sizeof(char *) * end))) {\n", ind, rest, rest, name);
+    fprintf(out, "%s  goto noMem;\n", ind);
+    fprintf(out, "%s}\n", ind);
+    fprintf(out, "%sa.%s[counts[%d]++] = argv[i];\n", ind, rest, restIdx);
+  }
+  if(posCount) {
+    fprintf(out, "      }\n");
+  }
+  fprintf(out, "      continue;\n");
+  fprintf(out, "    }\n\n");
+
+  if(!groupsCount) {
+    fprintf(out, "    return %s_fail(mem, oerr, \"Ambiguous argument \\\"%%.*s\\\" provided\", len, arg);\n", name);
+    fprintf(out, "  }\n\n");
+  } else {
+    fprintf(out, "    val = arg[len] == '=' ? argv[i] + len + 1 : NULL;\n");
+    fprintf(out, "    switch(%s_match(arg, len)) {\n", name);
+    int ai = 0;
+    for(int gi = 0; gi < groupsCount; gi++) {
+      const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[gi];
+      for(int i = 0; i < schema->floatsCount; i++) {
+        if(schema->floats[i].groupIdx == gi) {
+          fprintf(out, "      case %d:\n", i);
+        }
+      }
+      if(!gr->isRepeating) {
+        fprintf(out, "        if(used[%d] & ", gi / 64);
+        write_bit(out, gi);
+        fprintf(out, ") {\n");
+        fprintf(out, "          goto twice;\n");
+        fprintf(out, "        }\n");
+      }
+      if(gr->hasAssign && !gr->isAssignOptional) {
+        fprintf(out, "        if(!val) {\n");
+        fprintf(out, "          goto noValue;\n");
+        fprintf(out, "        }\n");
+      } else if(!gr->hasAssign) {
+        fprintf(out, "        if(val) {\n");
+        fprintf(out, "          goto needlessValue;\n");
+        fprintf(out, "        }\n");
+      }
+      write_take(out, name, "        ", schema, gi, ai);
+      ai += gr->isRepeating;
+      fprintf(out, "        break;\n");
+    }
+    fprintf(out, "      default:\n");
+    fprintf(out, "        res = %s_fail(mem, oerr, \"Ambiguous argument \\\"%%.*s\\\" provided\", len, arg);\n", name);
+    fprintf(out, "        goto done;\n");
+    fprintf(out, "    }\n");
+    fprintf(out, "  }\n\n");
+  }
+
+  // Command line > environment > defaults
+  int ai = 0;
+  for(int gi = 0; gi < groupsCount; gi++) {
+    const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[gi];
+    if(gr->envLen) {
+      fprintf(out, "  if(!(used[%d] & ", gi / 64);
+      write_bit(out, gi);
+      fprintf(out, ") && (val = %s_env(opts ? opts->envp : NULL, \"%.*s\", %d))) {\n", name, gr->envLen, gr->env,
+              gr->envLen);
+      fprintf(out, "    arg = \"%.*s\";\n", gr->envLen, gr->env);
+      fprintf(out, "    len = %d;\n", gr->envLen);
+      write_take(out, name, "    ", schema, gi, ai);
+      fprintf(out, "  }\n");
+    }
+    ai += gr->isRepeating;
+  }
+  if(hasEnv) {
+    fprintf(out, "\n");
+  }
+
+  // Bitmask of the required groups per word, the first missing one is named
+  for(int w = 0; w < words; w++) {
+    unsigned long long mask = 0;
+    for(int gi = w * 64; gi < groupsCount && gi < (w + 1) * 64; gi++) {
+      mask |= schema->groups[gi].isOptional ? 0 : 1ULL << (gi % 64);
+    }
+    if(!mask) {
+      continue;
+    }
+    fprintf(out, "  if((used[%d] & 0x%llxull) != 0x%llxull) {\n", w, mask, mask);
+    for(int gi = w * 64; gi < groupsCount && gi < (w + 1) * 64; gi++) {
+      const EXT_ARGS_FloatArgsGroup *gr = &schema->groups[gi];
+      if(gr->isOptional) {
+        continue;
+      }
+      const EXT_ARGS_FloatArg *fa = schema->floats;
+      while(fa->groupIdx != gi) {
+        fa++;
+      }
+      fprintf(out, "    if(!(used[%d] & ", w);
+      write_bit(out, gi);
+      fprintf(out, ")) {\n");
+      fprintf(out, "      res = %s_fail(mem, oerr, \"\\\"%.*s\\\" argument %srequired but not provided\");\n", name,
+              fa->len, fa->str, gr->aliasCount > 1 ? "(or alias) " : "");
+      fprintf(out, "      goto done;\n");
+      fprintf(out, "    }\n");
+    }
+    fprintf(out, "  }\n");
+  }
+  if(mandatoryPos) {
+    fprintf(out, "  if(pos < %d) {\n", mandatoryPos);
+    fprintf(out, "    res = %s_fail(mem, oerr, \"Not enough positional arguments provided\");\n", name);
+    fprintf(out, "    goto done;\n");
+    fprintf(out, "  }\n");
+  }
+  if(!schema->varPosArgsEnabled) {
+    fprintf(out, "  if(pos > %d) {\n", posCount);
+    fprintf(out, "    res = %s_fail(mem, oerr, \"Too many positional arguments provided\");\n", name);
+    fprintf(out, "    goto done;\n");
+    fprintf(out, "  }\n");
+  }
+  fprintf(out, "\n");
+
+  // Arrays end with NULL, an empty one when nothing was given
+  ai = 0;
+  for(int i = 0; i < fieldsCount; i++) {
+    bool isArray = i < groupsCount ? schema->groups[i].isRepeating : i == fieldsCount - 1 && schema->varPosArgsEnabled;
+    if(!isArray) {
+      continue;
+    }
+    fprintf(out, "  if(!a.%s && !(a.%s = %s_alloc(mem, sizeof(char *)))) {\n", fields[i], fields[i], name);
+    fprintf(out, "    goto noMem;\n");
+    fprintf(out, "  }\n");
+    fprintf(out, "  a.%s[counts[%d]] = NULL;\n", fields[i], ai++);
+  }
+  fprintf(out, "  *dst = a;\n");
+  fprintf(out, "  return EXT_ARGS_NO_ERR;\n\n");
+
+  if(twice) {
+    fprintf(out, "twice:\n");
+    fprintf(out, "  res = %s_fail(mem, oerr, \"Same arguments provided multiple times: %%.*s\", len, arg);\n", name);
+    fprintf(out, "  goto done;\n");
+  }
+  if(noValue) {
+    fprintf(out, "noValue:\n");
+    fprintf(out, "  res = %s_fail(mem, oerr, \"\\\"%%.*s\\\" argument requires a value\", len, arg);\n", name);
+    fprintf(out, "  goto done;\n");
+  }
+  if(needless) {
+    fprintf(out, "needlessValue:\n");
+    fprintf(out, "  res = %s_fail(mem, oerr, \"\\\"%%.*s\\\" argument does not require a value\", len, arg);\n", name);
+    fprintf(out, "  goto done;\n");
+  }
+  if(typed) {
+    fprintf(out, "invalid:\n");
+    fprintf(out, "  res = %s_fail(mem, oerr, \"Invalid value \\\"%%s\\\" of \\\"%%.*s\\\" argument\", val, len, arg);\n",
+            name);
+    fprintf(out, "  goto done;\n");
+    fprintf(out, "range:\n");
+    fprintf(out, "  res = %s_fail(mem, oerr, \"Value \\\"%%s\\\" of \\\"%%.*s\\\" argument is out of range\", val, len,\n"
+                 "      arg);\n", name);
+    fprintf(out, "  goto done;\n");
+  }
+  if(arrays) {
+    fprintf(out, "noMem:\n");
+    fprintf(out, "  res = EXT_ARGS_NO_MEM_ERR;\n");
+  }
+  fprintf(out, "done:\n");
+  for(int i = 0; i < fieldsCount; i++) {
+    bool isArray = i < groupsCount ? schema->groups[i].isRepeating : i == fieldsCount - 1 && schema->varPosArgsEnabled;
+    if(isArray) {
+      fprintf(out, "  %s_free(mem, a.%s);\n", name, fields[i]);
+    }
+  }
+  fprintf(out, "  return res;\n");
+  fprintf(out, "}\n");
+}
+
+static void write_header(FILE *out, const char *name, const char *fmt, const ext_args_schema *schema) {
+  fprintf(out, "// Generated by ext_args_gen, don't edit\n");
+  fprintf(out, "// Schema: %s\n\n", fmt);
+
+  fprintf(out, "typedef struct {\n");
+  for(int i = 0; i < schema->groupsCount; i++) {
+    fprintf(out, "  %s%s;\n", group_type(&schema->groups[i]), fields[i]);
+  }
+  for(int i = 0; i < schema->posArgsCount; i++) {
+    fprintf(out, "  char *%s;\n", fields[schema->groupsCount + i]);
+  }
+  if(schema->varPosArgsEnabled) {
+    fprintf(out, "  char **%s;\n", fields[fieldsCount - 1]);
+  }
+  fprintf(out, "} %s_args;\n\n", name);
+
+  if(schema->groupsCount) {
+    write_match(out, name, schema);
+  }
+  write_tables(out, name, schema);
+
+  fprintf(out, "static const size_t %s_offsets[] = {\n", name);
+  for(int i = 0; i < fieldsCount; i++) {
+    fprintf(out, "  offsetof(%s_args, %s),\n", name, fields[i]);
+  }
+  if(!schema->varPosArgsEnabled) { // the variadic slot is always read
+    fprintf(out, "  EXT_ARGS_UNBOUND,\n");
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out, "static const ext_args_bound %s_bound = {&%s_schema, %s_offsets};\n\n", name, name, name);
+
+  write_parse(out, name, schema);
+}
+
+static int gen(int argc, char *argv[], char *fmt, ...) {
+  char *err;
+  va_list ap;
+  va_start(ap, fmt);
+  int res = ext_args(argc, argv, fmt, ap, &err);
+  va_end(ap);
+  if(res != EXT_ARGS_NO_ERR) {
+    fprintf(stderr, "%s\nUsage: ext_args_gen %s\n", err ? err : "Out of memory", fmt);
+    free(err);
+  }
+  return res;
+}
+
+int main(int argc, char *argv[]) {
+  char *output, *name, *fmt;
+  if(gen(argc, argv, "[-o|--output=path] name schema", &output, &name, &fmt) != EXT_ARGS_NO_ERR) {
+    return EXIT_FAILURE;
+  }
+
+  ext_args_schema *schema;
+  char *err;
+  if(ext_args_compile(fmt, &schema, &err) != EXT_ARGS_NO_ERR) {
+    fprintf(stderr, "%s\n", err ? err : "Out of memory");
+    free(err);
+    return EXIT_FAILURE;
+  }
+
+  fields = malloc(sizeof(*fields) * (schema->groupsCount + schema->posArgsCount + 1));
+  if(!fields) {
+    fprintf(stderr, "Can't allocate memory\n");
+    return EXIT_FAILURE;
+  }
+  for(int i = 0; i < schema->groupsCount; i++) {
+    const EXT_ARGS_FloatArg *longest = NULL;
+    for(int j = 0; j < schema->floatsCount; j++) {
+      const EXT_ARGS_FloatArg *f = &schema->floats[j];
+      if(f->groupIdx == i && (!longest || f->len > longest->len)) {
+        longest = f;
+      }
+    }
+    add_field(longest->str, longest->len);
+  }
+  for(int i = 0; i < schema->posArgsCount; i++) {
+    add_field(schema->posArgs[i].str, schema->posArgs[i].len);
+  }
+  if(schema->varPosArgsEnabled) {
+    add_field("rest", 4);
+  }
+
+  FILE *out = output ? fopen(output, "w") : stdout;
+  if(!out) {
+    perror(output);
+    return EXIT_FAILURE;
+  }
+  write_header(out, name, fmt, schema);
+  if(out != stdout) {
+    fclose(out);
+  }
+
+  free(fields);
+  ext_args_schema_free(schema);
+  return EXIT_SUCCESS;
+}
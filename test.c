@@ -1,5 +1,44 @@
 #include <assert.h>
+#define EXT_ARGS_IMPLEMENTATION
 #include "ext_args.h"
+#include "tool_gen.h"
+#include "job_gen.h"
+
+typedef struct {
+  char *f;
+  bool v;
+  long long n;
+  char **d;
+  char *name;
+  char *last;
+  char **rest;
+} Config;
+
+typedef struct {
+  int count;
+  int lastId;
+  char lastAlias[16];
+  char *lastVal;
+} Emitted;
+
+static void write_file(const char *path, const char *content) {
+  FILE *f = fopen(path, "wb");
+  assert(f);
+  fputs(content, f);
+  fclose(f);
+}
+
+static bool same_str(const char *a, const char *b) {
+  return a == b || (a && b && !strcmp(a, b));
+}
+
+static void collect(void *ud, int id, const char *alias, int aliasLen, char *val) {
+  Emitted *e = ud;
+  e->count++;
+  e->lastId = id;
+  snprintf(e->lastAlias, sizeof(e->lastAlias), "%.*s", aliasLen, alias ? alias : "");
+  e->lastVal = val;
+}
 
 int eargs(int argc, char *argv[], char *fmt, char **oerr, ...) {
   va_list ap;
@@ -9,6 +48,58 @@ int eargs(int argc, char *argv[], char *fmt, char **oerr, ...) {
   return res;
 }
 
+int sparse(const ext_args_schema *schema, int argc, char *argv[], char **oerr, ...) {
+  va_list ap;
+  va_start(ap, oerr);
+  int res = ext_args_parse(schema, argc, argv, ap, oerr);
+  va_end(ap);
+  return res;
+}
+
+int sparse_ex(const ext_args_schema *schema, const ext_args_options *opts, int argc, char *argv[], char **oerr, ...) {
+  va_list ap;
+  va_start(ap, oerr);
+  int res = ext_args_parse_ex(schema, opts, argc, argv, ap, oerr);
+  va_end(ap);
+  return res;
+}
+
+typedef struct {
+  int allocs;
+  int frees;
+} Counter;
+
+void *counting_alloc(void *ud, size_t size) {
+  ((Counter *)ud)->allocs++;
+  return malloc(size);
+}
+
+void *counting_realloc(void *ud, void *ptr, size_t oldSize, size_t size) {
+  if(!ptr) {
+    ((Counter *)ud)->allocs++;
+  }
+  return realloc(ptr, size);
+}
+
+void counting_free(void *ud, void *ptr) {
+  if(ptr) {
+    ((Counter *)ud)->frees++;
+  }
+  free(ptr);
+}
+
+// "[-f|--file=val] [-v|--verbose] [-D=val...] [-n=val:int@NUM] [-c[=val]] src [dst] ..."
+#define TOOL_SCHEMA(GROUP, POS) \
+  GROUP(file, EXT_ARGS_F_OPTIONAL | EXT_ARGS_F_VALUE, EXT_ARGS_T_STR, "", "-f", "--file") \
+  GROUP(verbose, EXT_ARGS_F_OPTIONAL, EXT_ARGS_T_STR, "", "-v", "--verbose") \
+  GROUP(define, EXT_ARGS_F_OPTIONAL | EXT_ARGS_F_REPEATING, EXT_ARGS_T_STR, "", "-D") \
+  GROUP(num, EXT_ARGS_F_OPTIONAL | EXT_ARGS_F_VALUE, EXT_ARGS_T_INT, "NUM", "-n") \
+  GROUP(color, EXT_ARGS_F_OPTIONAL | EXT_ARGS_F_VALUE_OPTIONAL, EXT_ARGS_T_STR, "", "-c") \
+  POS(src, 0) \
+  POS(dst, EXT_ARGS_F_OPTIONAL)
+
+EXT_ARGS_DEFINE_SCHEMA(tool_schema, TOOL_SCHEMA, true)
+
 int main() {
    // Schema Lexing errors
   {
@@ -397,4 +488,1423 @@ int main() {
       }
     }
   }
+  // Precompiled schema
+  {
+    {
+      ext_args_schema *schema = NULL;
+      char *err = NULL;
+      int res = ext_args_compile("[a", &schema, &err);
+      assert(res == EXT_ARGS_SCHEMA_ERR);
+      assert(schema == NULL);
+      assert(!strcmp(err, "Schema parsing error. Expected EOI but received LBRAK, starting from \"[a\""));
+      free(err);
+    }
+
+    // Same schema, several inputs
+    {
+      char fmt[] = "-a=val [-b] [-D=val...] c ...";
+      ext_args_schema *schema = NULL;
+      char *err = NULL;
+      int res = ext_args_compile(fmt, &schema, &err);
+      assert(res == EXT_ARGS_NO_ERR);
+      assert(err == NULL);
+      memset(fmt, ' ', sizeof(fmt) - 1); // schema keeps its own copy
+
+      for(int i = 0; i < 3; i++) {
+        char *a = NULL, *c = NULL;
+        bool b = true;
+        char **d = NULL, **opts = NULL;
+        res = sparse(schema, 5, (char *[]){"", "-a=1", "-D=x", "-D=y", "two"}, &err, &a, &b, &d, &c, &opts);
+        assert(res == EXT_ARGS_NO_ERR);
+        assert(err == NULL);
+        assert(!strcmp(a, "1"));
+        assert(b == false);
+        assert(!strcmp(d[0], "x"));
+        assert(!strcmp(d[1], "y"));
+        assert(d[2] == NULL);
+        assert(!strcmp(c, "two"));
+        assert(*opts == NULL);
+        free(d);
+        free(opts);
+      }
+
+      res = sparse(schema, 3, (char *[]){"", "-a=1", "-b"}, &err, NULL, NULL, NULL, NULL, NULL);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, "Not enough positional arguments provided"));
+      free(err);
+
+      ext_args_schema_free(schema);
+    }
+  }
+  // Many aliases
+  {
+    char fmt[300 * 16];
+    char *p = fmt;
+    p += sprintf(p, "[-o0");
+    for(int i = 1; i < 300; i++) {
+      p += sprintf(p, "|--opt%d", i);
+    }
+    p += sprintf(p, "=val] [-D] [-D=val...]");
+
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile(fmt, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    // The first of the same aliases wins
+    {
+      char *o = NULL;
+      bool d = false;
+      char **dd = NULL;
+      res = sparse(schema, 3, (char *[]){"", "--opt299=a", "-D"}, &err, &o, &d, &dd);
+      assert(res == EXT_ARGS_NO_ERR);
+      assert(!strcmp(o, "a"));
+      assert(d == true);
+      assert(*dd == NULL);
+      free(dd);
+    }
+
+    {
+      res = sparse(schema, 3, (char *[]){"", "--opt299=a", "--opt7=b"}, &err, NULL, NULL, NULL);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, "Same arguments provided multiple times: --opt7"));
+      free(err);
+    }
+
+    {
+      res = sparse(schema, 2, (char *[]){"", "--opt300=a"}, &err, NULL, NULL, NULL);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, "Ambiguous argument \"--opt300\" provided"));
+      free(err);
+    }
+
+    ext_args_schema_free(schema);
+  }
+  // Large input
+  {
+    int argc = 100001;
+    char **argv = malloc(sizeof(*argv) * argc);
+    argv[0] = "";
+    for(int i = 1; i < argc; i++) {
+      argv[i] = i % 2 ? "-D=x" : "y";
+    }
+
+    char *err = NULL;
+    char **d = NULL, **opts = NULL;
+    int res = eargs(argc, argv, "-D=val... ...", &err, &d, &opts);
+    assert(res == EXT_ARGS_NO_ERR);
+    int dCount = 0, optsCount = 0;
+    while(d[dCount]) dCount++;
+    while(opts[optsCount]) optsCount++;
+    assert(dCount == 50000);
+    assert(optsCount == 50000);
+    free(d);
+    free(opts);
+    free(argv);
+  }
+  // Arena
+  {
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("-a=val [-D=val...] ...", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    static char buf[4096];
+    ext_args_arena arena;
+    ext_args_arena_init(&arena, buf, sizeof(buf));
+    ext_args_options opts = {.arena = &arena};
+
+    for(int i = 0; i < 3; i++) {
+      char *a = NULL;
+      char **d = NULL, **opts_ = NULL;
+      res = sparse_ex(schema, &opts, 5, (char *[]){"", "-a=1", "-D=x", "-D=y", "f"}, &err, &a, &d, &opts_);
+      assert(res == EXT_ARGS_NO_ERR);
+      assert(!strcmp(a, "1"));
+      assert((char *)d >= buf && (char *)d < buf + sizeof(buf));
+      assert(!strcmp(d[0], "x"));
+      assert(!strcmp(d[1], "y"));
+      assert(d[2] == NULL);
+      assert((char *)opts_ >= buf && (char *)opts_ < buf + sizeof(buf));
+      assert(!strcmp(opts_[0], "f"));
+      assert(opts_[1] == NULL);
+
+      res = sparse_ex(schema, &opts, 2, (char *[]){"", "-b"}, &err, NULL, NULL, NULL);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(err >= buf && err < buf + sizeof(buf));
+      assert(!strcmp(err, "Ambiguous argument \"-b\" provided"));
+
+      ext_args_arena_reset(&arena);
+    }
+
+    // Exhausted arena
+    {
+      static char small[8];
+      char **d = NULL, **opts_ = NULL;
+      ext_args_arena_init(&arena, small, sizeof(small));
+      res = sparse_ex(schema, &opts, 3, (char *[]){"", "-a=1", "f"}, &err, NULL, &d, &opts_);
+      assert(res == EXT_ARGS_NO_MEM_ERR);
+    }
+
+    ext_args_schema_free(schema);
+  }
+  // Allocator
+  {
+    Counter c = {0};
+    ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile_ex("-a=val [-D=val...] ...", &allocator, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(c.allocs > 0);
+
+    ext_args_options opts = {.allocator = &allocator};
+    char **d = NULL, **opts_ = NULL;
+    res = sparse_ex(schema, &opts, 4, (char *[]){"", "-a=1", "-D=x", "f"}, &err, NULL, &d, &opts_);
+    assert(res == EXT_ARGS_NO_ERR);
+    allocator.free(allocator.ud, d);
+    allocator.free(allocator.ud, opts_);
+
+    res = sparse_ex(schema, &opts, 2, (char *[]){"", "-b"}, &err, NULL, NULL, NULL);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    allocator.free(allocator.ud, err);
+
+    ext_args_schema_free(schema);
+
+    res = ext_args_compile_ex("[a", &allocator, &schema, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    allocator.free(allocator.ud, err);
+
+    assert(c.allocs == c.frees);
+  }
+  // Inline storage, nothing allocated for small inputs
+  {
+    Counter c = {0};
+    ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("-a=val [-b] [-c[=val]] d [e]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    ext_args_options opts = {.allocator = &allocator};
+    char *a = NULL, *cc = NULL, *d = NULL, *e = NULL;
+    bool b = false;
+    res = sparse_ex(schema, &opts, 5, (char *[]){"", "-a=1", "-b", "-c", "x"}, &err, &a, &b, &cc, &d, &e);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!strcmp(a, "1"));
+    assert(b == true);
+    assert(cc == ext_args_no_value);
+    assert(!strcmp(d, "x"));
+    assert(e == NULL);
+    assert(c.allocs == 0);
+
+    // Bigger than the inline storage
+    int argc = EXT_ARGS_INLINE_ARGS * 3 + 3;
+    char **argv = malloc(sizeof(*argv) * argc);
+    argv[0] = "";
+    argv[1] = "-a=1";
+    for(int i = 2; i < argc; i++) {
+      argv[i] = "-b";
+    }
+    res = sparse_ex(schema, &opts, argc, argv, &err, NULL, NULL, NULL, NULL, NULL);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Same arguments provided multiple times: -b"));
+    allocator.free(allocator.ud, err);
+    assert(c.allocs > 0);
+    assert(c.allocs == c.frees);
+    free(argv);
+
+    ext_args_schema_free(schema);
+  }
+  // Typed values
+  {
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("-n=val:int [-u=val:uint] [-r=val:f64] [-s=val:size] [-t=val:duration] "
+                               "[-b=val:bool] [-x[=val:int]] [-v=val:str]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    long long n = 0, x = 7;
+    unsigned long long u = 5;
+    double r = 0.5, t = 1;
+    size_t sz = 3;
+    bool b = false;
+    char *v = "x";
+
+    res = sparse(schema, 8, (char *[]){"", "-n=-42", "-u=18446744073709551615", "-r=2.5e-3",
+                 "-s=64K", "-t=250ms", "-b=yes", "-v=a"}, &err, &n, &u, &r, &sz, &t, &b, &x, &v);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(n == -42);
+    assert(u == 18446744073709551615ULL);
+    assert(r == 2.5e-3);
+    assert(sz == 64 * 1024);
+    assert(t == 0.25);
+    assert(b == true);
+    assert(x == 7);
+    assert(!strcmp(v, "a"));
+
+    // Not provided typed values keep the defaults
+    u = 5; r = 0.5; sz = 3; t = 1; b = true; x = 7;
+    res = sparse(schema, 3, (char *[]){"", "-n=9223372036854775807", "-x"}, &err, &n, &u, &r, &sz, &t, &b, &x, &v);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(n == LLONG_MAX);
+    assert(u == 5 && r == 0.5 && sz == 3 && t == 1 && b == true && x == 7);
+    assert(v == NULL);
+
+    res = sparse(schema, 3, (char *[]){"", "-n=1", "-x=-9223372036854775808"}, &err, &n, &u, &r, &sz, &t, &b, &x, &v);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(x == LLONG_MIN);
+
+    res = sparse(schema, 5, (char *[]){"", "-n=0", "-r=0.1234567890123456789012", "-s=2GiB", "-t=1.5h"},
+                 &err, &n, &u, &r, &sz, &t, &b, &x, &v);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(r == strtod("0.1234567890123456789012", NULL));
+    assert(sz == (size_t)2 << 30);
+    assert(t == 5400);
+
+    res = sparse(schema, 2, (char *[]){"", "-n=12a"}, &err, &n, &u, &r, &sz, &t, &b, &x, &v);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Invalid value \"12a\" of \"-n\" argument"));
+    free(err);
+
+    n = 1;
+    res = sparse(schema, 3, (char *[]){"", "-n=9223372036854775808", "-b=1"}, &err, &n, &u, &r, &sz, &t, &b, &x, &v);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Value \"9223372036854775808\" of \"-n\" argument is out of range"));
+    assert(n == 1);
+    free(err);
+
+    char *bad[][2] = {
+      {"-u=-1", "Invalid value \"-1\" of \"-u\" argument"},
+      {"-u=18446744073709551616", "Value \"18446744073709551616\" of \"-u\" argument is out of range"},
+      {"-r=1e999", "Value \"1e999\" of \"-r\" argument is out of range"},
+      {"-r=1,5", "Invalid value \"1,5\" of \"-r\" argument"},
+      {"-s=1Q", "Invalid value \"1Q\" of \"-s\" argument"},
+      {"-t=5y", "Invalid value \"5y\" of \"-t\" argument"},
+      {"-t=-1s", "Value \"-1s\" of \"-t\" argument is out of range"},
+      {"-b=maybe", "Invalid value \"maybe\" of \"-b\" argument"}
+    };
+    for(int i = 0; i < (int)(sizeof(bad) / sizeof(*bad)); i++) {
+      res = sparse(schema, 2, (char *[]){"", bad[i][0]}, &err, &n, &u, &r, &sz, &t, &b, &x, &v);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, bad[i][1]));
+      free(err);
+    }
+
+    ext_args_schema_free(schema);
+
+    res = ext_args_compile("-n=val:number", &schema, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    assert(!strcmp(err, "Schema parsing error. Unknown value type, starting from \"number\""));
+    free(err);
+
+    res = ext_args_compile("[-D=val:int...]", &schema, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    assert(!strcmp(err, "Repeating argument \"-D\" can't have a typed value"));
+    free(err);
+  }
+  // Binding table
+  {
+    ext_args_schema *schema = NULL;
+    ext_args_bound *bound = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("-f|--file=val [-v] [-n=val:int] [-D=val...] name [last] ...", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    static const ext_args_binding table[] = {
+      EXT_ARGS_BIND(Config, f, "--file"),
+      EXT_ARGS_BIND(Config, v, "-v"),
+      EXT_ARGS_BIND(Config, n, "-n"),
+      EXT_ARGS_BIND(Config, d, "-D"),
+      EXT_ARGS_BIND(Config, name, "name"),
+      EXT_ARGS_BIND(Config, rest, "..."),
+      EXT_ARGS_BIND_END
+    };
+    res = ext_args_bind(schema, table, &bound, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    for(int i = 0; i < 1000; i++) {
+      Config cfg = {.n = 10, .last = "untouched"};
+      res = ext_args_parse_into(bound, NULL, 7, (char *[]){"", "-f=a", "-v", "-D=x", "-D=y", "nm", "l"}, &cfg, &err);
+      assert(res == EXT_ARGS_NO_ERR);
+      assert(!strcmp(cfg.f, "a"));
+      assert(cfg.v == true);
+      assert(cfg.n == 10);
+      assert(!strcmp(cfg.d[0], "x") && !strcmp(cfg.d[1], "y") && cfg.d[2] == NULL);
+      assert(!strcmp(cfg.name, "nm"));
+      assert(!strcmp(cfg.last, "untouched"));
+      assert(cfg.rest[0] == NULL);
+      free(cfg.d);
+      free(cfg.rest);
+    }
+
+    Config cfg = {0};
+    res = ext_args_parse_into(bound, NULL, 2, (char *[]){"", "-n=x"}, &cfg, &err);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Invalid value \"x\" of \"-n\" argument"));
+    free(err);
+
+    ext_args_bound_free(bound);
+
+    typedef struct { int n; } Bad;
+    res = ext_args_bind(schema, (ext_args_binding[]){EXT_ARGS_BIND(Bad, n, "-n"), EXT_ARGS_BIND_END}, &bound, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    assert(!strcmp(err, "Binding \"-n\" field size is 4, expected 8"));
+    free(err);
+
+    res = ext_args_bind(schema, (ext_args_binding[]){EXT_ARGS_BIND(Config, f, "-x"), EXT_ARGS_BIND_END}, &bound, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    assert(!strcmp(err, "Unknown binding \"-x\""));
+    free(err);
+
+    res = ext_args_bind(schema, (ext_args_binding[]){
+      EXT_ARGS_BIND(Config, f, "-f"), EXT_ARGS_BIND(Config, last, "--file"), EXT_ARGS_BIND_END}, &bound, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    assert(!strcmp(err, "Argument \"--file\" is bound more than once"));
+    free(err);
+
+    // Typed bindings check what the size can't
+    res = ext_args_bind(schema, (ext_args_binding[]){EXT_ARGS_BIND_INT(Config, n, "--file"), EXT_ARGS_BIND_END},
+        &bound, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    assert(!strcmp(err, "Binding \"--file\" field type is long long, expected char *"));
+    free(err);
+
+    res = ext_args_bind(schema, (ext_args_binding[]){
+      EXT_ARGS_BIND_STR(Config, f, "-f"),
+      EXT_ARGS_BIND_BOOL(Config, v, "-v"),
+      EXT_ARGS_BIND_INT(Config, n, "-n"),
+      EXT_ARGS_BIND_LIST(Config, d, "-D"),
+      EXT_ARGS_BIND_STR(Config, name, "name"),
+      EXT_ARGS_BIND_LIST(Config, rest, "..."),
+      EXT_ARGS_BIND_END
+    }, &bound, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    ext_args_bound_free(bound);
+
+    ext_args_schema_free(schema);
+  }
+  // Streaming
+  {
+    ext_args_schema *schema = NULL;
+    ext_args_bound *bound = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("-f|--file=val [-v] [-n=val:int] [-D|--def=val...] name [last] ...", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    res = ext_args_bind(schema, (ext_args_binding[]){
+      EXT_ARGS_BIND(Config, f, "-f"),
+      EXT_ARGS_BIND(Config, v, "-v"),
+      EXT_ARGS_BIND(Config, n, "-n"),
+      EXT_ARGS_BIND(Config, name, "name"),
+      EXT_ARGS_BIND(Config, last, "last"),
+      EXT_ARGS_BIND_END
+    }, &bound, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    ext_args_stream st;
+    Emitted e = {0};
+    Config cfg = {.v = true, .n = 3, .last = "x"};
+    assert(ext_args_stream_init(&st, bound, &cfg, collect, &e) == EXT_ARGS_NO_ERR);
+
+    char *args[] = {"-f", "=", "a", "nm", "-n=5"};
+    for(int i = 0; i < 5; i++) {
+      assert(ext_args_feed(&st, args[i], &err) == EXT_ARGS_NO_ERR);
+    }
+    for(int i = 0; i < 100000; i++) {
+      assert(ext_args_feed(&st, i % 2 ? "--def=x" : "-D=y", &err) == EXT_ARGS_NO_ERR);
+      assert(ext_args_feed(&st, "extra", &err) == EXT_ARGS_NO_ERR);
+    }
+    assert(e.count == 199999);
+    assert(e.lastId == 6 && !strcmp(e.lastAlias, "") && !strcmp(e.lastVal, "extra"));
+    assert(ext_args_feed(&st, "--def=z", &err) == EXT_ARGS_NO_ERR);
+    assert(e.count == 200000);
+    assert(e.lastId == 3 && !strcmp(e.lastAlias, "--def") && !strcmp(e.lastVal, "z"));
+    assert(ext_args_feed(&st, "--", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "-unknown", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "-v", &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "The stream is finished"));
+    free(err);
+
+    assert(!strcmp(cfg.f, "a"));
+    assert(cfg.v == false);
+    assert(cfg.n == 5);
+    assert(!strcmp(cfg.name, "nm"));
+    assert(!strcmp(cfg.last, "extra"));
+
+    // Errors
+    assert(ext_args_stream_init(&st, bound, &cfg, NULL, NULL) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "nm", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "\"-f\" argument (or alias) required but not provided"));
+    free(err);
+
+    assert(ext_args_stream_init(&st, bound, &cfg, NULL, NULL) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "-f=", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "A value expected \"-f=\""));
+    free(err);
+
+    assert(ext_args_stream_init(&st, bound, &cfg, NULL, NULL) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "-v", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "-v", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "-f", &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Same arguments provided multiple times: -v"));
+    free(err);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "The stream has failed before"));
+    free(err);
+
+    ext_args_bound_free(bound);
+    ext_args_schema_free(schema);
+
+    // Feeding a failed stream
+    res = ext_args_compile("[-v] [-x]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    res = ext_args_bind(schema, (ext_args_binding[]){EXT_ARGS_BIND_END}, &bound, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(ext_args_stream_init(&st, bound, NULL, NULL, NULL) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "-q", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "-x", &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Ambiguous argument \"-q\" provided"));
+    free(err);
+    for(int i = 0; i < 2; i++) {
+      assert(ext_args_feed(&st, "-v", &err) == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, "The stream has failed before"));
+      free(err);
+    }
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_INPUT_ERR);
+    free(err);
+    ext_args_bound_free(bound);
+    ext_args_schema_free(schema);
+
+    res = ext_args_compile("a", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    res = ext_args_bind(schema, (ext_args_binding[]){EXT_ARGS_BIND_END}, &bound, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(ext_args_stream_init(&st, bound, NULL, NULL, NULL) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "x", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_feed(&st, "y", &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Too many positional arguments provided"));
+    free(err);
+    ext_args_bound_free(bound);
+    ext_args_schema_free(schema);
+
+    // The environment and a config file fill what wasn't fed
+    res = ext_args_compile("-n=val:int@X_N -f=val [-v]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    res = ext_args_bind(schema, (ext_args_binding[]){
+      EXT_ARGS_BIND_STR(Config, f, "-f"),
+      EXT_ARGS_BIND_BOOL(Config, v, "-v"),
+      EXT_ARGS_BIND_INT(Config, n, "-n"),
+      EXT_ARGS_BIND_END
+    }, &bound, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    write_file("/tmp/ext_args_test_stream.conf", "f = conf\nn = 1\nv = yes");
+    ext_args_config *conf = NULL;
+    assert(ext_args_config_load("/tmp/ext_args_test_stream.conf", NULL, &conf, &err) == EXT_ARGS_NO_ERR);
+
+    Config c = {0};
+    assert(ext_args_stream_init(&st, bound, &c, NULL, NULL) == EXT_ARGS_NO_ERR);
+    st.envp = (char *[]){"X_N=7", NULL};
+    st.config = conf;
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_NO_ERR);
+    assert(c.n == 7 && !strcmp(c.f, "conf") && c.v == true);
+
+    c = (Config){0};
+    assert(ext_args_stream_init(&st, bound, &c, NULL, NULL) == EXT_ARGS_NO_ERR);
+    st.envp = (char *[]){NULL};
+    st.config = conf;
+    assert(ext_args_feed(&st, "-f=arg", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_NO_ERR);
+    assert(c.n == 1 && !strcmp(c.f, "arg") && c.v == true);
+
+    assert(ext_args_stream_init(&st, bound, &c, NULL, NULL) == EXT_ARGS_NO_ERR);
+    st.envp = (char *[]){"X_N=x", NULL};
+    assert(ext_args_feed(&st, "-f=arg", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Invalid value \"x\" of \"X_N\" argument"));
+    free(err);
+
+    assert(ext_args_stream_init(&st, bound, &c, NULL, NULL) == EXT_ARGS_NO_ERR);
+    st.envp = (char *[]){NULL};
+    assert(ext_args_feed(&st, "-f=arg", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "\"-n\" argument required but not provided"));
+    free(err);
+
+    ext_args_config_free(conf);
+    remove("/tmp/ext_args_test_stream.conf");
+    ext_args_bound_free(bound);
+    ext_args_schema_free(schema);
+  }
+  // Emitting repeating and variadic values
+  {
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("[-I|--inc=val...] [-v] out ...", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    int argc = 200002;
+    char **argv = malloc(sizeof(*argv) * argc);
+    argv[0] = "";
+    for(int i = 1; i < argc - 1; i += 2) {
+      argv[i] = "-I=dir";
+      argv[i + 1] = "file";
+    }
+    argv[argc - 1] = "--inc=last";
+
+    Emitted e = {0};
+    ext_args_options opts = {.emit = collect, .ud = &e};
+    char **inc = (char **)&e, **files = (char **)&e, *out = NULL;
+    bool v = true;
+    res = sparse_ex(schema, &opts, argc, argv, &err, &inc, &v, &out, &files);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(e.count == 100001 + 99999);
+    assert(e.lastId == 3 && !strcmp(e.lastAlias, "") && !strcmp(e.lastVal, "file"));
+    assert(inc == (char **)&e && files == (char **)&e);
+    assert(!strcmp(out, "file"));
+    assert(v == false);
+    free(argv);
+
+    e = (Emitted){0};
+    res = sparse_ex(schema, &opts, 3, (char *[]){"", "o", "f"}, &err, NULL, NULL, NULL, NULL);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(e.count == 1 && e.lastId == 3 && !strcmp(e.lastVal, "f"));
+
+    ext_args_schema_free(schema);
+  }
+  // Response files
+  {
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("[-I=val...] [-o=val] [-v] ...", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    write_file("/tmp/ext_args_test_a.rsp", "-I=a\n  'b c' \"d \\\"e\\\"\" f\\ g\n@/tmp/ext_args_test_b.rsp -o=out\n");
+    write_file("/tmp/ext_args_test_b.rsp", "-v\t-I=\"x y\"");
+
+    ext_args_response_files rf = {0};
+    ext_args_options opts = {.responseFiles = &rf};
+    char **inc = NULL, *o = NULL, **rest = NULL;
+    bool v = false;
+    res = sparse_ex(schema, &opts, 4, (char *[]){"", "first", "@/tmp/ext_args_test_a.rsp", "last"}, &err, &inc, &o, &v, &rest);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!strcmp(inc[0], "a") && !strcmp(inc[1], "x y") && inc[2] == NULL);
+    assert(!strcmp(o, "out"));
+    assert(v == true);
+    assert(!strcmp(rest[0], "first") && !strcmp(rest[1], "b c") && !strcmp(rest[2], "d \"e\""));
+    assert(!strcmp(rest[3], "f g") && !strcmp(rest[4], "last") && rest[5] == NULL);
+    assert(rf.mapsCount == 2);
+    free(inc);
+    free(rest);
+    ext_args_response_files_release(&rf);
+
+    // Without the option "@" is an ordinary argument
+    res = sparse(schema, 2, (char *[]){"", "@/tmp/ext_args_test_a.rsp"}, &err, &inc, &o, &v, &rest);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!strcmp(rest[0], "@/tmp/ext_args_test_a.rsp"));
+    free(inc);
+    free(rest);
+
+    // A page sized file ending with an argument
+    char *page = malloc(4097);
+    memset(page, ' ', 4096);
+    memcpy(page + 4096 - 4, "-o=z", 4);
+    page[4096] = '\0';
+    write_file("/tmp/ext_args_test_a.rsp", page);
+    free(page);
+    res = sparse_ex(schema, &opts, 2, (char *[]){"", "@/tmp/ext_args_test_a.rsp"}, &err, NULL, &o, NULL, NULL);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!strcmp(o, "z"));
+    ext_args_response_files_release(&rf);
+
+    write_file("/tmp/ext_args_test_a.rsp", "-v @/tmp/ext_args_test_a.rsp");
+    res = sparse_ex(schema, &opts, 2, (char *[]){"", "@/tmp/ext_args_test_a.rsp"}, &err, NULL, NULL, NULL, NULL);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Response files nested too deep \"@/tmp/ext_args_test_a.rsp\""));
+    assert(rf.mapsCount == EXT_ARGS_RESPONSE_DEPTH);
+    free(err);
+    ext_args_response_files_release(&rf);
+
+    res = sparse_ex(schema, &opts, 2, (char *[]){"", "@/tmp/ext_args_test_none.rsp"}, &err, NULL, NULL, NULL, NULL);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Can't read response file \"/tmp/ext_args_test_none.rsp\""));
+    free(err);
+    ext_args_response_files_release(&rf);
+
+    // The list of files isn't allocated in the arena, it outlives a reset
+    static char abuf[4096];
+    ext_args_arena arena;
+    ext_args_arena_init(&arena, abuf, sizeof(abuf));
+    ext_args_options aopts = {.arena = &arena, .responseFiles = &rf};
+    write_file("/tmp/ext_args_test_a.rsp", "-v -o=out");
+    res = sparse_ex(schema, &aopts, 2, (char *[]){"", "@/tmp/ext_args_test_a.rsp"}, &err, NULL, &o, &v, NULL);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!strcmp(o, "out") && v == true);
+    assert(rf.mapsCount == 1);
+    assert((char *)rf.maps < abuf || (char *)rf.maps >= abuf + sizeof(abuf));
+    ext_args_arena_reset(&arena);
+    memset(abuf, 0xff, sizeof(abuf));
+    ext_args_response_files_release(&rf);
+
+    // Files that can't be mapped are read with stdio
+    res = sparse_ex(schema, &opts, 3, (char *[]){"", "@/dev/null", "x"}, &err, NULL, NULL, NULL, &rest);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!strcmp(rest[0], "x") && rest[1] == NULL);
+    free(rest);
+    ext_args_response_files_release(&rf);
+
+    remove("/tmp/ext_args_test_a.rsp");
+    remove("/tmp/ext_args_test_b.rsp");
+    ext_args_schema_free(schema);
+  }
+  // Environment variables
+  {
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("--threads=n:int@APP_THREADS [--mode=val@APP_MODE] [--name=val@APP_NAME] "
+                               "[-D=val@APP_DEFS...] [-x[=val@APP_X]]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    char *envp[] = {"PATH=/bin", "APP_THREADS=16", "APP_MODE=fast", "APP_NAME=", "APP_DEFS=a", "APP_MODE=slow", NULL};
+    ext_args_options opts = {.envp = envp};
+    long long threads = 0;
+    char *mode = NULL, *name = "x", *xv = NULL, **defs = NULL;
+    res = sparse_ex(schema, &opts, 1, (char *[]){""}, &err, &threads, &mode, &name, &defs, &xv);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(threads == 16);
+    assert(!strcmp(mode, "fast"));
+    assert(name == NULL);
+    assert(!strcmp(defs[0], "a") && defs[1] == NULL);
+    assert(xv == NULL);
+    free(defs);
+
+    // The command line wins
+    res = sparse_ex(schema, &opts, 3, (char *[]){"", "--threads=2", "-D=b"}, &err, &threads, &mode, &name, &defs, &xv);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(threads == 2);
+    assert(!strcmp(defs[0], "b") && defs[1] == NULL);
+    free(defs);
+
+    envp[1] = "APP_THREADS=many";
+    res = sparse_ex(schema, &opts, 1, (char *[]){""}, &err, &threads, &mode, &name, &defs, &xv);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Invalid value \"many\" of \"APP_THREADS\" argument"));
+    free(err);
+
+    envp[1] = "OTHER=1";
+    res = sparse_ex(schema, &opts, 1, (char *[]){""}, &err, &threads, &mode, &name, &defs, &xv);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "\"--threads\" argument required but not provided"));
+    free(err);
+
+    ext_args_schema_free(schema);
+
+    res = ext_args_compile("-a=val@", &schema, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    assert(!strcmp(err, "Schema parsing error. Expected NAME but received EOI, starting from \"\""));
+    free(err);
+  }
+  // Config file
+  {
+    ext_args_schema *schema = NULL;
+    char *err = NULL;
+    int res = ext_args_compile("--threads=n:int@APP_THREADS [-o|--output=val] [-v] [--dry-run] [-I=val...] "
+                               "[--mode=val@APP_MODE] [--level=val]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    write_file("/tmp/ext_args_test.conf",
+      "# defaults\n"
+      "threads = 8\n"
+      "\n"
+      "  output=\" out dir \"\r\n"
+      "; flags\n"
+      "v\n"
+      "dry-run = no\n"
+      "I = a\n"
+      "-I = b\n"
+      "level = 3");
+
+    ext_args_config *cfg = NULL;
+    res = ext_args_config_load("/tmp/ext_args_test.conf", NULL, &cfg, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    char *envp[] = {"APP_THREADS=16", "APP_MODE=env", NULL};
+    ext_args_options opts = {.config = cfg, .envp = (char *[]){NULL}};
+    long long threads0 = 0;
+    res = sparse_ex(schema, &opts, 1, (char *[]){""}, &err, &threads0, NULL, NULL, NULL, NULL, NULL, NULL);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(threads0 == 8);
+    opts.envp = envp;
+
+    long long threads = 0;
+    char *out = NULL, **inc = NULL, *mode = NULL, *level = NULL;
+    bool v = false, dry = true;
+    res = sparse_ex(schema, &opts, 1, (char *[]){""}, &err, &threads, &out, &v, &dry, &inc, &mode, &level);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(threads == 16);
+    assert(!strcmp(out, " out dir "));
+    assert(v == true);
+    assert(dry == false);
+    assert(!strcmp(inc[0], "a") && !strcmp(inc[1], "b") && inc[2] == NULL);
+    assert(!strcmp(mode, "env"));
+    assert(!strcmp(level, "3"));
+    free(inc);
+
+    // The command line wins, repeating arguments are taken from one source
+    res = sparse_ex(schema, &opts, 4, (char *[]){"", "--threads=2", "-I=c", "--level=9"}, &err,
+                    &threads, &out, &v, &dry, &inc, &mode, &level);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(threads == 2);
+    assert(!strcmp(inc[0], "c") && inc[1] == NULL);
+    assert(!strcmp(level, "9"));
+    assert(!strcmp(out, " out dir "));
+    free(inc);
+    ext_args_config_free(cfg);
+
+    opts.envp = (char *[]){NULL};
+    char *bad[][2] = {
+      {"threads = x\n", "Invalid value \"x\" of \"threads\" argument"},
+      {"v = maybe\n", "Invalid value \"maybe\" of \"v\" argument"},
+      {"v = 1\nv\n", "Same arguments provided multiple times: v"},
+      {"output\n", "\"output\" argument requires a value"},
+      {"color = red\n", "Unknown config key \"color\""}
+    };
+    for(int i = 0; i < (int)(sizeof(bad) / sizeof(*bad)); i++) {
+      write_file("/tmp/ext_args_test.conf", bad[i][0]);
+      res = ext_args_config_load("/tmp/ext_args_test.conf", NULL, &cfg, &err);
+      assert(res == EXT_ARGS_NO_ERR);
+      opts.config = cfg;
+      res = sparse_ex(schema, &opts, 1, (char *[]){""}, &err, &threads, &out, &v, &dry, &inc, &mode, &level);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, bad[i][1]));
+      free(err);
+      ext_args_config_free(cfg);
+    }
+
+    write_file("/tmp/ext_args_test.conf", "a = 1\n = 2\n");
+    res = ext_args_config_load("/tmp/ext_args_test.conf", NULL, &cfg, &err);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Config file \"/tmp/ext_args_test.conf\" line 2 has no key"));
+    free(err);
+
+    remove("/tmp/ext_args_test.conf");
+    res = ext_args_config_load("/tmp/ext_args_test.conf", NULL, &cfg, &err);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Can't read config file \"/tmp/ext_args_test.conf\""));
+    free(err);
+
+    ext_args_schema_free(schema);
+  }
+
+  // Schema defined at compile time
+  {
+    ext_args_schema *parsed;
+    char *err;
+    int res = ext_args_compile("[-f|--file=val] [-v|--verbose] [-D=val...] [-n=val:int@NUM] [-c[=val]] src [dst] ...",
+        &parsed, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    const ext_args_schema *schema = tool_schema();
+    assert(schema == tool_schema());
+    assert(schema->groupsCount == parsed->groupsCount);
+    assert(schema->floatsCount == parsed->floatsCount);
+    assert(schema->posArgsCount == parsed->posArgsCount);
+    assert(schema->sequenceCount == parsed->sequenceCount);
+    assert(schema->varPosArgsEnabled);
+    for(int i = 0; i < schema->groupsCount; i++) {
+      EXT_ARGS_FloatArgsGroup a = schema->groups[i], b = parsed->groups[i];
+      assert(a.isOptional == b.isOptional && a.hasAssign == b.hasAssign);
+      assert(a.isAssignOptional == b.isAssignOptional && a.isRepeating == b.isRepeating);
+      assert(a.aliasCount == b.aliasCount && a.valType == b.valType && a.seqIdx == b.seqIdx);
+      assert(a.envLen == b.envLen && !strncmp(a.env, b.env ? b.env : "", a.envLen));
+    }
+    for(int i = 0; i < schema->floatsCount; i++) {
+      EXT_ARGS_FloatArg a = schema->floats[i], b = parsed->floats[i];
+      assert(a.len == b.len && !strncmp(a.str, b.str, a.len) && a.groupIdx == b.groupIdx);
+    }
+    for(int i = 0; i < schema->posArgsCount; i++) {
+      EXT_ARGS_PosArg a = schema->posArgs[i], b = parsed->posArgs[i];
+      assert(a.isOptional == b.isOptional && a.len == b.len && !strncmp(a.str, b.str, a.len));
+    }
+    for(int i = 0; i < schema->sequenceCount; i++) {
+      assert(schema->sequence[i].type == parsed->sequence[i].type);
+      assert(schema->sequence[i].idx == parsed->sequence[i].idx);
+    }
+    ext_args_schema_free(parsed);
+
+    char *f, *color, *src, *dst, **d, **rest;
+    bool verbose;
+    long long n = 3;
+    ext_args_options opts = {.envp = (char *[]){"NUM=12", NULL}};
+    res = sparse_ex(schema, &opts, 7, (char *[]){"", "--verbose", "-D=a", "-c", "in", "-D=b", "x"}, &err,
+        &f, &verbose, &d, &n, &color, &src, &dst, &rest);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!f && verbose && n == 12 && color == ext_args_no_value);
+    assert(!strcmp(d[0], "a") && !strcmp(d[1], "b") && !d[2]);
+    assert(!strcmp(src, "in") && !strcmp(dst, "x") && !rest[0]);
+    free(d);
+    free(rest);
+
+    res = sparse(schema, 2, (char *[]){"", "-n=1"}, &err, &f, &verbose, &d, &n, &color, &src, &dst, &rest);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Not enough positional arguments provided"));
+    free(err);
+  }
+
+  // Generated schema
+  {
+    const char *aliases[] = {"-f", "--file", "-v", "--verbose", "-D", "-n", "-c"};
+    for(int i = 0; i < (int)(sizeof(aliases) / sizeof(*aliases)); i++) {
+      assert(tool_gen_match(aliases[i], strlen(aliases[i])) == i);
+      assert(!strcmp(tool_gen_schema.floats[i].str, aliases[i]));
+    }
+    assert(tool_gen_match("-x", 2) == -1);
+    assert(tool_gen_match("--filx", 6) == -1);
+    assert(tool_gen_match("-", 1) == -1);
+
+    tool_gen_args a = {.n = 3};
+    char *err;
+    ext_args_options opts = {.envp = (char *[]){"NUM=12", NULL}};
+    int res = tool_gen_parse(&opts, 8, (char *[]){"", "--file=x", "-D=a", "-c=red", "in", "-D=b", "out", "more"},
+        &a, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!strcmp(a.file, "x") && !a.verbose && a.n == 12 && !strcmp(a.c, "red"));
+    assert(!strcmp(a.D[0], "a") && !strcmp(a.D[1], "b") && !a.D[2]);
+    assert(!strcmp(a.src, "in") && !strcmp(a.dst, "out") && !strcmp(a.rest[0], "more") && !a.rest[1]);
+    free(a.D);
+    free(a.rest);
+
+    res = tool_gen_parse(NULL, 3, (char *[]){"", "in", "--fil"}, &a, &err);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Ambiguous argument \"--fil\" provided"));
+    free(err);
+  }
+
+  // Generated parser against the runtime
+  {
+    char *cases[][10] = {
+      {"in", "-o=x"},
+      {"in", "--out=x", "-j=4", "-s=64K", "-t=250ms", "-q", "-I=a", "-I=b", "two"},
+      {"in"},
+      {"-o=x"},
+      {"a", "b", "c", "-o=x"},
+      {"a", "-o=x", "--out=y"},
+      {"a", "-o"},
+      {"a", "-o=x", "-q=1"},
+      {"a", "-o=x", "-j=abc"},
+      {"a", "-o=x", "--jobs=99999999999999999999999"},
+      {"a", "-o=x", "-t"},
+      {"a", "-o=x", "-t=-1s"},
+      {"a", "-o=x", "-s=1Q"},
+      {"a", "-o=x", "-z"},
+      {"a", "-o=x", "-z", "-q+"},
+      {"a", "-o=", "-q+"},
+      {"a", "=x", "-o="},
+      {"a", "-o=", "=x"},
+      {"a", "-o=x", "--", "-z", "b", "c"},
+      {"-", "-o=x", "--jobs=5", "-I=c"},
+    };
+    char *envs[][2] = {{"JOBS=8", NULL}, {"JOBS=x", NULL}, {"JOBS=", NULL}};
+
+    for(int e = 0; e < 3; e++) {
+      for(int c = 0; c < (int)(sizeof(cases) / sizeof(*cases)); c++) {
+        char *argv[11] = {""};
+        int argc = 1;
+        for(; argc <= 10 && cases[c][argc - 1]; argc++) {
+          argv[argc] = cases[c][argc - 1];
+        }
+
+        ext_args_options opts = {.envp = envs[e]};
+        job_gen_args g = {.jobs = 1, .s = 2, .t = 3}, r = g;
+        char *gerr, *rerr;
+        int gres = job_gen_parse(&opts, argc, argv, &g, &gerr);
+        int rres = ext_args_parse_into(&job_gen_bound, &opts, argc, argv, &r, &rerr);
+        assert(gres == rres && same_str(gerr, rerr));
+        if(gres == EXT_ARGS_NO_ERR) {
+          assert(same_str(g.out, r.out) && g.jobs == r.jobs && g.s == r.s && g.t == r.t && g.q == r.q);
+          assert(same_str(g.file, r.file) && same_str(g.more, r.more));
+          for(int i = 0; g.I[i] || r.I[i]; i++) {
+            assert(same_str(g.I[i], r.I[i]));
+          }
+          free(g.I);
+          free(r.I);
+        }
+        free(gerr);
+        free(rerr);
+      }
+    }
+
+    // Arena, the struct is untouched on errors
+    char buf[512];
+    ext_args_arena arena;
+    ext_args_arena_init(&arena, buf, sizeof(buf));
+    ext_args_options opts = {.arena = &arena, .envp = (char *[]){NULL}};
+    job_gen_args g = {.jobs = 1};
+    char *err;
+    int res = job_gen_parse(&opts, 4, (char *[]){"", "in", "-o=x", "-I=a"}, &g, &err);
+    assert(res == EXT_ARGS_NO_ERR && g.jobs == 1 && !strcmp(g.I[0], "a") && !g.I[1]);
+    assert((char *)g.I >= buf && (char *)g.I < buf + sizeof(buf));
+
+    char **I = g.I;
+    res = job_gen_parse(&opts, 4, (char *[]){"", "in", "-o=y", "-j=z"}, &g, &err);
+    assert(res == EXT_ARGS_INPUT_ERR && !strcmp(err, "Invalid value \"z\" of \"-j\" argument"));
+    assert(!strcmp(g.out, "x") && g.I == I);
+
+    ext_args_arena_init(&arena, buf, 8);
+    res = job_gen_parse(&opts, 4, (char *[]){"", "in", "-o=x", "-I=a"}, &g, &err);
+    assert(res == EXT_ARGS_NO_MEM_ERR && !err);
+  }
+
+  // Serialized schema
+  {
+    char *fmt = "[-f|--file=val] [-v] [-D=val...] [-n=val:int@NUM] src [dst] ...";
+    const char *path = "/tmp/ext_args_test.schema";
+    remove(path);
+
+    ext_args_schema *schema;
+    char *err;
+    int res = ext_args_compile_cached(fmt, path, NULL, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!schema->map.addr);
+    ext_args_schema_free(schema);
+
+    res = ext_args_compile_cached(fmt, path, NULL, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(schema->map.addr);
+    assert(schema->groupsCount == 4 && schema->floatsCount == 5 && schema->posArgsCount == 2);
+    assert(schema->groups[3].envLen == 3 && !strncmp(schema->groups[3].env, "NUM", 3));
+
+    char *f, *src, *dst, **d, **rest;
+    bool v;
+    long long n = 0;
+    res = sparse(schema, 6, (char *[]){"", "--file=a", "in", "-D=x", "-n=5", "-v"}, &err,
+        &f, &v, &d, &n, &src, &dst, &rest);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!strcmp(f, "a") && v && n == 5 && !strcmp(d[0], "x") && !d[1]);
+    assert(!strcmp(src, "in") && !dst && !rest[0]);
+    free(d);
+    free(rest);
+
+    res = sparse(schema, 2, (char *[]){"", "--nope"}, &err, &f, &v, &d, &n, &src, &dst, &rest);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    free(err);
+
+    // Saved again from the mapped schema, the file is the same
+    res = ext_args_schema_save(schema, "/tmp/ext_args_test2.schema", &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    ext_args_schema_free(schema);
+    res = ext_args_compile_cached(fmt, "/tmp/ext_args_test2.schema", NULL, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(schema->map.addr);
+    ext_args_schema_free(schema);
+    remove("/tmp/ext_args_test2.schema");
+
+    // Stale, compiled and saved again
+    res = ext_args_compile_cached("[-v] src", path, NULL, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!schema->map.addr && schema->groupsCount == 1);
+    ext_args_schema_free(schema);
+    res = ext_args_compile_cached("[-v] src", path, NULL, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(schema->map.addr && schema->groupsCount == 1);
+    ext_args_schema_free(schema);
+
+    // Corrupt
+    FILE *file = fopen(path, "r+b");
+    assert(file);
+    fseek(file, sizeof(EXT_ARGS_ImageHeader) + 4, SEEK_SET);
+    fputc(0x7f, file);
+    fclose(file);
+    res = ext_args_compile_cached("[-v] src", path, NULL, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!schema->map.addr && schema->groupsCount == 1);
+    ext_args_schema_free(schema);
+
+    write_file(path, "short");
+    res = ext_args_compile_cached("[-v] src", path, NULL, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!schema->map.addr);
+    ext_args_schema_free(schema);
+
+    res = ext_args_compile_cached("[-v", path, NULL, &schema, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR);
+    free(err);
+
+    res = ext_args_schema_save(tool_schema(), path, &err);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Only compiled schemas can be saved"));
+    free(err);
+
+    res = ext_args_compile(fmt, &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    res = ext_args_schema_save(schema, "/nonexistent/ext_args.schema", &err);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Can't write schema file \"/nonexistent/ext_args.schema\""));
+    free(err);
+    ext_args_schema_free(schema);
+    remove(path);
+  }
+
+  // Arguments classifier agrees with the schema lexer
+  {
+    const char alphabet[] = "--aZ0_=. \x80";
+    unsigned seed = 1;
+    char buf[64];
+    for(int k = 0; k < 20000; k++) {
+      int len = k % 40;
+      for(int i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        buf[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+      }
+      buf[len] = '\0';
+      if(k % 3 == 0 && len > 1) {
+        buf[1] = 'a';
+      }
+
+      char *arg = malloc(len + 1 + k % 16);
+      assert(arg);
+      char *str = arg + k % 16;
+      memcpy(str, buf, len + 1);
+      EXT_ARGS_Parser prs = {.str = str};
+      int expected = EXT_ARGS_ArgFloat(&prs) ? (int)(prs.str - str) : 0;
+      assert(EXT_ARGS_FloatLen(str) == expected);
+      free(arg);
+    }
+    assert(EXT_ARGS_FloatLen("----------------------------------a-b_c9-----------------d=1") == 58);
+    assert(EXT_ARGS_FloatLen("--abcdefghijklmnopqrstuvwxyz0123456789-") == 0);
+    assert(EXT_ARGS_FloatLen("-") == 0 && EXT_ARGS_FloatLen("") == 0 && EXT_ARGS_FloatLen("-9") == 0);
+  }
+
+  // Abbreviations of long aliases
+  {
+    ext_args_schema *schema;
+    char *err;
+    int res = ext_args_compile("[--verbose] [--version] [--dry-run|--dry-running] [--all] [--allow=val] [-v]",
+        &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    bool verbose, version, dry, all, v;
+    char *allow;
+    ext_args_options opts = {.abbrev = true};
+    res = sparse_ex(schema, &opts, 5, (char *[]){"", "--verb", "--dry-r", "--all", "--allo=x"}, &err,
+        &verbose, &version, &dry, &all, &allow, &v);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(verbose && !version && dry && all && !strcmp(allow, "x") && !v);
+
+    char *bad[][2] = {
+      {"--ver", "Ambiguous argument \"--ver\", it may be --verbose, --version"},
+      {"--al=1", "Ambiguous argument \"--al\", it may be --all, --allow"},
+      {"--verbx", "Ambiguous argument \"--verbx\" provided"},
+      {"-verb", "Ambiguous argument \"-verb\" provided"}
+    };
+    for(int i = 0; i < (int)(sizeof(bad) / sizeof(*bad)); i++) {
+      res = sparse_ex(schema, &opts, 2, (char *[]){"", bad[i][0]}, &err, &verbose, &version, &dry, &all, &allow, &v);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, bad[i][1]));
+      free(err);
+    }
+
+    res = sparse(schema, 2, (char *[]){"", "--verb"}, &err, &verbose, &version, &dry, &all, &allow, &v);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Ambiguous argument \"--verb\" provided"));
+    free(err);
+
+    ext_args_bound *bound;
+    assert(ext_args_bind(schema, (ext_args_binding[]){EXT_ARGS_BIND_END}, &bound, &err) == EXT_ARGS_NO_ERR);
+    ext_args_stream st;
+    Emitted e = {0};
+    assert(ext_args_stream_init(&st, bound, NULL, collect, &e) == EXT_ARGS_NO_ERR);
+    st.abbrev = true;
+    assert(ext_args_feed(&st, "--vers", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_NO_ERR);
+    ext_args_bound_free(bound);
+    ext_args_schema_free(schema);
+
+    // Saved schemas get the tree too
+    const char *path = "/tmp/ext_args_test.schema";
+    remove(path);
+    char *fmt = "[--verbose] [--version]";
+    assert(ext_args_compile_cached(fmt, path, NULL, &schema, &err) == EXT_ARGS_NO_ERR);
+    ext_args_schema_free(schema);
+    assert(ext_args_compile_cached(fmt, path, NULL, &schema, &err) == EXT_ARGS_NO_ERR);
+    assert(schema->map.addr && schema->trie);
+    res = sparse_ex(schema, &opts, 2, (char *[]){"", "--versi"}, &err, &verbose, &version);
+    assert(res == EXT_ARGS_NO_ERR && !verbose && version);
+    ext_args_schema_free(schema);
+    remove(path);
+  }
+
+  // Clusters of single letter aliases
+  {
+    ext_args_schema *schema;
+    char *err;
+    int res = ext_args_compile("[-x] [-v] [-f|--file=val] [-D=val...] [-vx]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    bool x, v, vx;
+    char *f, **d;
+    ext_args_options opts = {.cluster = true};
+    res = sparse_ex(schema, &opts, 3, (char *[]){"", "-xvf=a.txt", "-D=1"}, &err, &x, &v, &f, &d, &vx);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(x && v && !strcmp(f, "a.txt") && d[0] && !strcmp(d[0], "1") && !d[1] && !vx);
+    free(d);
+
+    // An alias wins over a cluster of the same letters
+    res = sparse_ex(schema, &opts, 2, (char *[]){"", "-vx"}, &err, &x, &v, &f, &d, &vx);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!x && !v && vx);
+    free(d);
+
+    char *bad[][2] = {
+      {"-fx", "\"-f\" argument requires a value"},
+      {"-xq", "Ambiguous argument \"-xq\" provided"},
+      {"-xx", "Same arguments provided multiple times: -x"}
+    };
+    for(int i = 0; i < (int)(sizeof(bad) / sizeof(*bad)); i++) {
+      res = sparse_ex(schema, &opts, 2, (char *[]){"", bad[i][0]}, &err, &x, &v, &f, &d, &vx);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, bad[i][1]));
+      free(err);
+    }
+
+    res = sparse(schema, 2, (char *[]){"", "-xv"}, &err, &x, &v, &f, &d, &vx);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Ambiguous argument \"-xv\" provided"));
+    free(err);
+
+    ext_args_bound *bound;
+    assert(ext_args_bind(schema, (ext_args_binding[]){EXT_ARGS_BIND_END}, &bound, &err) == EXT_ARGS_NO_ERR);
+    ext_args_stream st;
+    Emitted e = {0};
+    assert(ext_args_stream_init(&st, bound, NULL, collect, &e) == EXT_ARGS_NO_ERR);
+    st.cluster = true;
+    assert(ext_args_feed(&st, "-xvD=1", &err) == EXT_ARGS_NO_ERR);
+    assert(ext_args_finish(&st, &err) == EXT_ARGS_NO_ERR);
+    assert(e.count == 1 && !strcmp(e.lastAlias, "-D") && !strcmp(e.lastVal, "1"));
+    ext_args_bound_free(bound);
+    ext_args_schema_free(schema);
+
+    // Saved schemas get the table too
+    const char *path = "/tmp/ext_args_test.schema";
+    remove(path);
+    char *fmt = "[-x] [-v]";
+    assert(ext_args_compile_cached(fmt, path, NULL, &schema, &err) == EXT_ARGS_NO_ERR);
+    ext_args_schema_free(schema);
+    assert(ext_args_compile_cached(fmt, path, NULL, &schema, &err) == EXT_ARGS_NO_ERR);
+    assert(schema->map.addr && schema->shortIndex);
+    res = sparse_ex(schema, &opts, 2, (char *[]){"", "-vx"}, &err, &x, &v);
+    assert(res == EXT_ARGS_NO_ERR && x && v);
+    ext_args_schema_free(schema);
+    remove(path);
+  }
+
+  // Batch validation
+  {
+    ext_args_schema *schema;
+    char *err;
+    int res = ext_args_compile("[-v] [-f|--file=val] [-n=val:int] [-D=val...] src [dst]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(ext_args_batch_words(schema) == 1);
+
+    static char *many[3001];
+    many[0] = "";
+    many[1] = "src";
+    for(int i = 2; i < 3001; i++) {
+      many[i] = "-D=x";
+    }
+    char **argvs[] = {
+      (char *[]){"", "-v", "a"},
+      (char *[]){"", "-n=x", "a"},
+      (char *[]){"", "-f=1"},
+      (char *[]){"", "--file=x", "a", "b"},
+      many
+    };
+    int argcs[] = {3, 3, 2, 4, 3001};
+    int status[5];
+    uint64_t used[5];
+
+    Counter c = {0};
+    ext_args_allocator allocator = {counting_alloc, counting_realloc, counting_free, &c};
+    ext_args_options opts = {.allocator = &allocator};
+    ext_args_batch_out out = {status, used};
+    res = ext_args_parse_batch(schema, &opts, 5, argcs, argvs, &out);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(status[0] == EXT_ARGS_NO_ERR && used[0] == 1);
+    assert(status[1] == EXT_ARGS_INPUT_ERR && used[1] == 0);
+    assert(status[2] == EXT_ARGS_INPUT_ERR);
+    assert(status[3] == EXT_ARGS_NO_ERR && used[3] == 2);
+    assert(status[4] == EXT_ARGS_NO_ERR && used[4] == 8);
+    // The arena and its regrowth for the last vector, nothing per vector
+    assert(c.allocs > 1 && c.allocs < 10 && c.allocs == c.frees);
+
+    res = ext_args_batch_error(schema, NULL, argcs[1], argvs[1], &err);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Invalid value \"x\" of \"-n\" argument"));
+    free(err);
+    res = ext_args_batch_error(schema, NULL, argcs[2], argvs[2], &err);
+    assert(res == EXT_ARGS_INPUT_ERR);
+    assert(!strcmp(err, "Not enough positional arguments provided"));
+    free(err);
+    ext_args_schema_free(schema);
+
+    // The environment is looked up once and serves every vector
+    res = ext_args_compile("[-v] -n=val:int@B_N src", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    char **envArgvs[] = {(char *[]){"", "a"}, (char *[]){"", "-n=x", "a"}, (char *[]){"", "-v", "a"}};
+    int envArgcs[] = {2, 3, 3};
+    opts = (ext_args_options){.envp = (char *[]){"B_N=3", NULL}};
+    res = ext_args_parse_batch(schema, &opts, 3, envArgcs, envArgvs, &out);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(status[0] == EXT_ARGS_NO_ERR && used[0] == 2);
+    assert(status[1] == EXT_ARGS_INPUT_ERR);
+    assert(status[2] == EXT_ARGS_NO_ERR && used[2] == 3);
+
+    opts.envp = (char *[]){"B_N=x", NULL};
+    res = ext_args_parse_batch(schema, &opts, 3, envArgcs, envArgvs, &out);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(status[0] == EXT_ARGS_INPUT_ERR && status[1] == EXT_ARGS_INPUT_ERR && status[2] == EXT_ARGS_INPUT_ERR);
+#ifdef EXT_ARGS_THREADS
+    opts.envp = (char *[]){"B_N=3", NULL};
+    res = ext_args_parse_batch_mt(schema, &opts, 3, envArgcs, envArgvs, &out, 2);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(status[0] == EXT_ARGS_NO_ERR && status[1] == EXT_ARGS_INPUT_ERR && status[2] == EXT_ARGS_NO_ERR);
+#endif
+    ext_args_schema_free(schema);
+  }
+
+#ifdef EXT_ARGS_THREADS
+  // Batch validation in threads
+  {
+    ext_args_schema *schema;
+    char *err;
+    int res = ext_args_compile("[-v] [-n=val:int] [-D=val...] src [dst]", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    char **kinds[] = {
+      (char *[]){"", "-v", "a"},
+      (char *[]){"", "-n=x", "a"},
+      (char *[]){"", "-D=1", "a", "b"},
+      (char *[]){"", "-v"}
+    };
+    int kindArgcs[] = {3, 3, 4, 2};
+    enum { N = 5000 };
+    static char **argvs[N];
+    static int argcs[N], status[N], statusMt[N];
+    static uint64_t used[N], usedMt[N];
+    for(int i = 0; i < N; i++) {
+      argvs[i] = kinds[i * 7 % 4];
+      argcs[i] = kindArgcs[i * 7 % 4];
+    }
+
+    res = ext_args_parse_batch(schema, NULL, N, argcs, argvs, &(ext_args_batch_out){status, used});
+    assert(res == EXT_ARGS_NO_ERR);
+    int counts[] = {0, 1, 3, 8, 64};
+    for(int k = 0; k < (int)(sizeof(counts) / sizeof(*counts)); k++) {
+      memset(statusMt, -1, sizeof(statusMt));
+      res = ext_args_parse_batch_mt(schema, NULL, N, argcs, argvs, &(ext_args_batch_out){statusMt, usedMt}, counts[k]);
+      assert(res == EXT_ARGS_NO_ERR);
+      assert(!memcmp(status, statusMt, sizeof(status)) && !memcmp(used, usedMt, sizeof(used)));
+    }
+    res = ext_args_parse_batch_mt(schema, NULL, 0, argcs, argvs, &(ext_args_batch_out){statusMt, usedMt}, 4);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    ext_args_schema_free(schema);
+  }
+#endif
+
+  // Subcommands
+  {
+    static const ext_args_command table[] = {
+      {"commit", "[-m=val] [--amend]"},
+      {"push", "[-f|--force] remote [branch]"},
+      {"broken", "[-x"}
+    };
+    ext_args_commands *cmds;
+    char *err;
+    int res = ext_args_commands_init("[-v] [-C=val]", table, 3, NULL, &cmds, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(!cmds->schemas[0] && !cmds->schemas[1] && !cmds->schemas[2]);
+
+    char *argv[] = {"git", "-v", "-C=/src", "push", "--force", "origin"};
+    int cmd, split;
+    const ext_args_schema *schema;
+    res = ext_args_dispatch(cmds, 6, argv, &cmd, &schema, &split, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+    assert(cmd == 1 && split == 3 && schema == cmds->schemas[1] && !cmds->schemas[0] && !cmds->schemas[2]);
+
+    bool v, force;
+    char *dir, *remote, *branch;
+    res = sparse(cmds->global, split, argv, &err, &v, &dir);
+    assert(res == EXT_ARGS_NO_ERR && v && !strcmp(dir, "/src"));
+    res = sparse(schema, 6 - split, argv + split, &err, &force, &remote, &branch);
+    assert(res == EXT_ARGS_NO_ERR && force && !strcmp(remote, "origin") && !branch);
+
+    // Compiled once
+    res = ext_args_dispatch(cmds, 2, (char *[]){"git", "push"}, &cmd, &schema, &split, &err);
+    assert(res == EXT_ARGS_NO_ERR && schema == cmds->schemas[1] && split == 1);
+
+    char *bad[][2] = {
+      {"-v", "A command expected"},
+      {"pull", "Unknown command \"pull\""}
+    };
+    for(int i = 0; i < (int)(sizeof(bad) / sizeof(*bad)); i++) {
+      res = ext_args_dispatch(cmds, 2, (char *[]){"git", bad[i][0]}, &cmd, &schema, &split, &err);
+      assert(res == EXT_ARGS_INPUT_ERR);
+      assert(!strcmp(err, bad[i][1]));
+      free(err);
+    }
+    res = ext_args_dispatch(cmds, 2, (char *[]){"git", "broken"}, &cmd, &schema, &split, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR && err && !cmds->schemas[2]);
+    free(err);
+    ext_args_commands_free(cmds);
+
+    static const ext_args_command twice[] = {{"a", ""}, {"b", ""}, {"a", "[-x]"}};
+    res = ext_args_commands_init("", twice, 3, NULL, &cmds, &err);
+    assert(res == EXT_ARGS_SCHEMA_ERR && !cmds);
+    assert(!strcmp(err, "Command \"a\" is defined more than once"));
+    free(err);
+  }
+
+  // Statistics
+  {
+    ext_args_stats before, after;
+    ext_args_stats_totals(&before);
+
+    ext_args_schema *schema;
+    char *err;
+    int res = ext_args_compile("[-v] [-D=val...] src", &schema, &err);
+    assert(res == EXT_ARGS_NO_ERR);
+
+    ext_args_stats st = {0};
+    ext_args_options opts = {.stats = &st};
+    bool v;
+    char **d, *src;
+    res = sparse_ex(schema, &opts, 5, (char *[]){"", "-v", "-D=1", "-D=2", "a"}, &err, &v, &d, &src);
+    assert(res == EXT_ARGS_NO_ERR);
+    free(d);
+    ext_args_stats_totals(&after);
+
+#ifdef EXT_ARGS_STATS
+    assert(st.parses == 1 && st.compiles == 0);
+    assert(st.tokens == 9 && st.floats == 3 && st.posArgs == 1);
+    assert(st.allocs + st.reallocs > 0 && st.bytes > 0);
+    assert(st.ticks[EXT_ARGS_PHASE_SYNOPSIS] == 0);
+    assert(st.ticks[EXT_ARGS_PHASE_LEX] + st.ticks[EXT_ARGS_PHASE_MATCH] + st.ticks[EXT_ARGS_PHASE_VALIDATE] +
+        st.ticks[EXT_ARGS_PHASE_FILL] > 0);
+    assert(after.parses - before.parses == 1 && after.compiles - before.compiles == 1);
+    assert(after.floats - before.floats == 3);
+
+    // Added up over the calls
+    res = sparse_ex(schema, &opts, 2, (char *[]){"", "a"}, &err, &v, &d, &src);
+    assert(res == EXT_ARGS_NO_ERR);
+    free(d);
+    assert(st.parses == 2 && st.posArgs == 2);
+#else
+    assert(st.parses == 0 && after.parses == 0 && after.compiles == 0);
+#endif
+    ext_args_schema_free(schema);
+  }
 }